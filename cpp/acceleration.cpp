@@ -0,0 +1,68 @@
+#include "acceleration.hpp"
+#include <algorithm>
+#include <cmath>
+
+// 根据速度计算倍数
+double AccelerationCurve::multiplier(double velocity) const {
+    double result = 1.0;
+
+    switch (type) {
+        case Type::None:
+            return 1.0;
+        case Type::Linear:
+            result = 1.0 + gain * std::max(0.0, velocity - threshold);
+            break;
+        case Type::Exponential:
+            if (threshold > 0.0 && velocity > threshold) {
+                result = std::pow(velocity / threshold, exponent);
+            }
+            break;
+        case Type::Points:
+            if (points.empty()) {
+                return 1.0;
+            }
+            if (velocity <= points.front().first) {
+                result = points.front().second;
+            } else if (velocity >= points.back().first) {
+                result = points.back().second;
+            } else {
+                auto upper = std::upper_bound(points.begin(), points.end(), velocity,
+                                              [](double value, const auto& point) { return value < point.first; });
+                auto lower = upper - 1;
+                const double span = upper->first - lower->first;
+                const double t = span > 0.0 ? (velocity - lower->first) / span : 1.0;
+                result = lower->second + t * (upper->second - lower->second);
+            }
+            break;
+    }
+
+    return std::clamp(result, 1.0, std::max(1.0, maxMultiplier));
+}
+
+// 记录一次转动并返回倍数
+double AccelerationEngine::onDetent(RotationAxis axis, int direction, uint64_t timestamp,
+                                    const AccelerationCurve& curve) {
+    constexpr uint64_t kResetGapNs = std::chrono::nanoseconds(kResetGap).count();
+    constexpr uint64_t kMinIntervalNs = std::chrono::nanoseconds(kMinInterval).count();
+
+    AxisState& state = m_axes[static_cast<size_t>(axis)];
+    const uint64_t interval = timestamp >= state.lastTimestamp ? timestamp - state.lastTimestamp : 0;
+
+    if (state.lastTimestamp == 0 || direction != state.direction || interval > kResetGapNs) {
+        // 停顿或换向之后重新开始估算
+        state.velocity = 0.0;
+    } else {
+        const double instant = 1e9 / static_cast<double>(std::max(interval, kMinIntervalNs));
+        // 指数平滑，单个抖动的间隔不会让倍数突变
+        state.velocity = state.velocity > 0.0 ? 0.5 * state.velocity + 0.5 * instant : instant;
+    }
+
+    state.lastTimestamp = timestamp;
+    state.direction = direction;
+    return curve.multiplier(state.velocity);
+}
+
+// 清除所有控件的速度
+void AccelerationEngine::reset() {
+    m_axes = {};
+}
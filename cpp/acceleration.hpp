@@ -0,0 +1,72 @@
+#ifndef ACCELERATION_HPP
+#define ACCELERATION_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 可以转动的控件
+enum class RotationAxis : uint8_t {
+    Knob = 0,  // 旋钮 0x44/0x04
+    Dial,      // 转盘 0x4F/0x0F
+    Wheel,     // 滚轮 0x49/0x09
+    Count
+};
+
+constexpr size_t kRotationAxisCount = static_cast<size_t>(RotationAxis::Count);
+
+// 加速曲线：把转动速度（刻度/秒）换算为倍数，倍数不小于 1
+struct AccelerationCurve {
+    enum class Type : uint8_t {
+        None,         // 不加速
+        Linear,       // 1 + gain * (速度 - threshold)
+        Exponential,  // (速度 / threshold) ^ exponent
+        Points        // 按 points 分段线性插值
+    };
+
+    Type type = Type::None;
+    double threshold = 5.0;      // 低于该速度时倍数为 1
+    double gain = 0.2;
+    double exponent = 1.5;
+    double maxMultiplier = 8.0;
+    std::vector<std::pair<double, double>> points;  // (速度, 倍数)，按速度递增
+
+    double multiplier(double velocity) const;
+};
+
+// 每个控件一条曲线
+using AccelerationProfile = std::array<AccelerationCurve, kRotationAxisCount>;
+
+// 加速引擎
+// 为每个控件记录上一次转动的时间，根据相邻两次转动的间隔估算速度，再通过曲线得到倍数。
+// 慢速转动（或停顿、换向之后的第一下）保持 1 倍，精确调节不受影响；快速拨动时成倍放大
+class AccelerationEngine {
+public:
+    // 超过该间隔视为重新开始转动
+    static constexpr std::chrono::milliseconds kResetGap{150};
+    // 同一批读取到的多个刻度时间戳相同，按该间隔估算速度
+    static constexpr std::chrono::milliseconds kMinInterval{4};
+
+    // 记录一次转动并返回倍数；direction 为 +1 或 -1，timestamp 为单调时钟纳秒数
+    double onDetent(RotationAxis axis, int direction, uint64_t timestamp, const AccelerationCurve& curve);
+
+    // 当前估算的速度（刻度/秒）
+    double velocity(RotationAxis axis) const { return m_axes[static_cast<size_t>(axis)].velocity; }
+
+    // 清除所有控件的速度
+    void reset();
+
+private:
+    struct AxisState {
+        uint64_t lastTimestamp = 0;
+        int direction = 0;
+        double velocity = 0.0;
+    };
+
+    std::array<AxisState, kRotationAxisCount> m_axes{};
+};
+
+#endif // ACCELERATION_HPP
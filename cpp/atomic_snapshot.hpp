@@ -0,0 +1,56 @@
+#ifndef ATOMIC_SNAPSHOT_HPP
+#define ATOMIC_SNAPSHOT_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// 通过原子指针发布的不可变快照（单写者，多读者）
+//
+// 读者调用 load() 只需要一次 acquire 读取，不加锁也不分配内存。
+// 写者用 publish() 替换快照，旧快照不会立即释放，而是放入一个固定大小的
+// 退役队列，在之后又发布了 kRetiredCapacity 个新快照后才销毁。
+// 因此读者可以在处理一批事件期间持有 load() 返回的指针，但不应跨越多次发布长期保存。
+template <typename T>
+class AtomicSnapshot {
+public:
+    static constexpr size_t kRetiredCapacity = 8;
+
+    explicit AtomicSnapshot(std::unique_ptr<const T> initial)
+        : m_owned(std::move(initial)) {
+        m_current.store(m_owned.get(), std::memory_order_release);
+    }
+
+    AtomicSnapshot(const AtomicSnapshot&) = delete;
+    AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+
+    // 读取当前快照
+    const T* load() const noexcept {
+        return m_current.load(std::memory_order_acquire);
+    }
+
+    // 发布新快照（只能由单个写者调用）
+    void publish(std::unique_ptr<const T> next) {
+        m_current.store(next.get(), std::memory_order_release);
+        m_retired[m_nextRetired] = std::move(m_owned);
+        m_nextRetired = (m_nextRetired + 1) % kRetiredCapacity;
+        m_owned = std::move(next);
+    }
+
+    // 取回最早退役的快照供写者复用，退役队列未满时返回空指针。
+    // 这个快照之后已经发布了 kRetiredCapacity 个新快照，与下一次 publish() 时销毁它的保证相同。
+    // 写者随后会原地改写它，没有代数检查，因此使用 recycle() 时读者应与写者在同一线程，
+    // 其他线程上的读者可能读到改写到一半的内容。只能用于以非 const 对象创建的快照
+    std::unique_ptr<T> recycle() {
+        return std::unique_ptr<T>(const_cast<T*>(m_retired[m_nextRetired].release()));
+    }
+
+private:
+    std::atomic<const T*> m_current;
+    std::unique_ptr<const T> m_owned;
+    std::array<std::unique_ptr<const T>, kRetiredCapacity> m_retired;
+    size_t m_nextRetired = 0;
+};
+
+#endif // ATOMIC_SNAPSHOT_HPP
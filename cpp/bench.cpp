@@ -0,0 +1,380 @@
+// 端到端基准测试
+// 打开一个伪终端，把从端路径作为串口设备启动驱动程序，事件通过 --output 写入管道而不是 /dev/uinput，
+// 按设定的速率回放合成的字节流，统计吞吐量、丢失的事件和从写入字节到收到事件的延迟分布。
+// 不需要硬件和 root 权限。
+//
+// 用法: tourbox_bench [驱动程序路径]
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <linux/input.h>
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "latency_stats.hpp"
+#include "uinput_helper.hpp"
+
+namespace {
+
+// 驱动程序初始化时向设备发送的命令长度
+constexpr size_t kInitCommandLength = 94;
+
+// 有按下/释放两个代码的按钮
+constexpr uint8_t kButtons[] = {0x80, 0x81, 0x82, 0x83, 0x90, 0x91, 0x92, 0x93, 0x8A, 0xAA, 0xA2, 0xA3, 0xB7, 0xB8};
+
+// 基准测试使用的配置：按钮映射到不同的按键，转盘映射到按键，滚轮映射到鼠标移动
+// 显式关闭加速，每个滚轮刻度固定移动 kRelativeStep，丢失刻度才能从移动总和算出
+const char* kBenchConfig = R"({
+    "presets": {
+        "default": {
+            "80": "KEY_A", "81": "KEY_B", "82": "KEY_C", "83": "KEY_D",
+            "90": "KEY_E", "91": "KEY_F", "92": "KEY_G", "93": "KEY_H",
+            "8A": "KEY_I", "AA": "KEY_J", "A2": "KEY_K", "A3": "KEY_L",
+            "B7": "KEY_M", "B8": "KEY_N",
+            "4F": "KEY_EQUAL", "0F": "KEY_MINUS",
+            "49": "REL_Y_NEG", "09": "REL_Y_POS"
+        }
+    },
+    "acceleration": {
+        "default": { "curve": "none" }
+    },
+    "window_rules": []
+})";
+
+struct ReceivedEvent {
+    uint64_t timestamp;
+    struct input_event event;
+};
+
+// 从管道读取驱动程序输出的事件
+class EventCollector {
+public:
+    explicit EventCollector(int fd) : m_fd(fd), m_thread([this]() { run(); }) {}
+
+    ~EventCollector() {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    // 取走目前收到的所有事件
+    std::vector<ReceivedEvent> take() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<ReceivedEvent> events;
+        events.swap(m_events);
+        return events;
+    }
+
+    // 等待满足条件的事件数量达到 expected，或者超过 timeout 没有新事件
+    template <typename Predicate>
+    size_t waitFor(size_t expected, Predicate predicate, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t matched = 0;
+        size_t scanned = 0;
+        while (true) {
+            for (; scanned < m_events.size(); ++scanned) {
+                if (predicate(m_events[scanned].event)) {
+                    matched++;
+                }
+            }
+            if (matched >= expected || m_closed) {
+                return matched;
+            }
+            if (m_changed.wait_for(lock, timeout) == std::cv_status::timeout && scanned == m_events.size()) {
+                return matched;
+            }
+        }
+    }
+
+private:
+    void run() {
+        std::vector<char> buffer(64 * 1024);
+        size_t buffered = 0;
+        while (true) {
+            ssize_t bytesRead = read(m_fd, buffer.data() + buffered, buffer.size() - buffered);
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead <= 0) {
+                break;
+            }
+            const uint64_t now = monotonicNanoseconds();
+            buffered += static_cast<size_t>(bytesRead);
+
+            const size_t complete = buffered / sizeof(struct input_event);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (size_t i = 0; i < complete; ++i) {
+                    ReceivedEvent received;
+                    received.timestamp = now;
+                    memcpy(&received.event, buffer.data() + i * sizeof(struct input_event), sizeof(struct input_event));
+                    m_events.push_back(received);
+                }
+            }
+            const size_t consumed = complete * sizeof(struct input_event);
+            memmove(buffer.data(), buffer.data() + consumed, buffered - consumed);
+            buffered -= consumed;
+            m_changed.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_changed.notify_all();
+    }
+
+    int m_fd;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<ReceivedEvent> m_events;
+    bool m_closed = false;
+    std::thread m_thread;
+};
+
+// 一个测试场景
+struct Scenario {
+    std::string name;
+    std::vector<uint8_t> bytes;
+    double bytesPerSecond;  // 0 表示尽快发送
+    // 每个输入字节对应一个标记事件，用于计算延迟和丢失；为空时只统计鼠标移动
+    bool (*isMarker)(const struct input_event&);
+    int relativeStep;       // 每个字节期望的 REL_Y（isMarker 为空时使用）
+};
+
+bool isKeyEvent(const struct input_event& event) {
+    return event.type == EV_KEY;
+}
+
+bool isKeyPress(const struct input_event& event) {
+    return event.type == EV_KEY && event.value == 1;
+}
+
+// 依次按下、释放每个按钮
+std::vector<uint8_t> makeButtonStorm(size_t count) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; bytes.size() < count; ++i) {
+        const uint8_t button = kButtons[i % std::size(kButtons)];
+        bytes.push_back(button);
+        bytes.push_back(button & 0x7F);
+    }
+    bytes.resize(count);
+    return bytes;
+}
+
+// 按节奏写入字节，返回每个字节的写入时间
+std::vector<uint64_t> sendBytes(int masterFd, const std::vector<uint8_t>& bytes, double bytesPerSecond) {
+    std::vector<uint64_t> sendTimes;
+    sendTimes.reserve(bytes.size());
+
+    if (bytesPerSecond <= 0) {
+        constexpr size_t kChunk = 64;
+        for (size_t offset = 0; offset < bytes.size(); offset += kChunk) {
+            const size_t length = std::min(kChunk, bytes.size() - offset);
+            const uint64_t now = monotonicNanoseconds();
+            if (write(masterFd, bytes.data() + offset, length) != static_cast<ssize_t>(length)) {
+                break;
+            }
+            sendTimes.insert(sendTimes.end(), length, now);
+        }
+        return sendTimes;
+    }
+
+    const uint64_t interval = static_cast<uint64_t>(1e9 / bytesPerSecond);
+    const uint64_t start = monotonicNanoseconds();
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const uint64_t target = start + i * interval;
+        struct timespec deadline;
+        deadline.tv_sec = static_cast<time_t>(target / 1000000000ull);
+        deadline.tv_nsec = static_cast<long>(target % 1000000000ull);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+
+        sendTimes.push_back(monotonicNanoseconds());
+        if (write(masterFd, &bytes[i], 1) != 1) {
+            break;
+        }
+    }
+    return sendTimes;
+}
+
+// 运行一个场景并输出结果
+void runScenario(int masterFd, EventCollector& collector, const Scenario& scenario) {
+    collector.take();
+
+    const std::vector<uint64_t> sendTimes = sendBytes(masterFd, scenario.bytes, scenario.bytesPerSecond);
+    const uint64_t sendEnd = monotonicNanoseconds();
+
+    if (scenario.isMarker) {
+        collector.waitFor(sendTimes.size(), scenario.isMarker, std::chrono::milliseconds(1000));
+    } else {
+        collector.waitFor(std::numeric_limits<size_t>::max(), isKeyEvent, std::chrono::milliseconds(300));
+    }
+    const std::vector<ReceivedEvent> events = collector.take();
+
+    LatencyHistogram latency;
+    size_t markers = 0;
+    size_t frames = 0;
+    long relativeSum = 0;
+    size_t relativeEvents = 0;
+    uint64_t lastArrival = sendEnd;
+
+    for (const ReceivedEvent& received : events) {
+        const struct input_event& event = received.event;
+        if (event.type == EV_SYN && event.code == SYN_REPORT) {
+            frames++;
+        } else if (event.type == EV_REL && event.code == REL_Y) {
+            relativeSum += event.value;
+            relativeEvents++;
+        }
+
+        if (scenario.isMarker && scenario.isMarker(event)) {
+            if (markers < sendTimes.size()) {
+                latency.record(received.timestamp - sendTimes[markers]);
+            }
+            markers++;
+        }
+        lastArrival = std::max(lastArrival, received.timestamp);
+    }
+
+    const double seconds = sendTimes.empty() ? 0.0 : static_cast<double>(lastArrival - sendTimes.front()) / 1e9;
+
+    std::cout << "== " << scenario.name << " ==" << std::endl;
+    std::cout << "  输入: " << sendTimes.size() << " 字节, 输出: " << events.size() << " 个事件 / "
+              << frames << " 帧, 耗时 " << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+    if (seconds > 0) {
+        std::cout << "  吞吐量: " << std::setprecision(0) << sendTimes.size() / seconds << " 字节/s, "
+                  << events.size() / seconds << " 事件/s" << std::endl;
+    }
+
+    if (scenario.isMarker) {
+        const long dropped = static_cast<long>(sendTimes.size()) - static_cast<long>(std::min(markers, sendTimes.size()));
+        std::cout << "  丢失事件: " << dropped << std::endl;
+        std::cout << "  延迟 (微秒): p50 " << std::setprecision(1) << latency.percentile(50) / 1000.0
+                  << ", p99 " << latency.percentile(99) / 1000.0
+                  << ", max " << latency.max() / 1000.0 << std::endl;
+    } else {
+        const long expectedRelative = static_cast<long>(sendTimes.size()) * scenario.relativeStep;
+        const long missing = (expectedRelative - relativeSum) / scenario.relativeStep;
+        std::cout << "  鼠标移动: 期望总和 " << expectedRelative << ", 实际 " << relativeSum
+                  << ", 丢失刻度 " << missing << ", 合并比 " << std::setprecision(2)
+                  << (relativeEvents > 0 ? static_cast<double>(sendTimes.size()) / relativeEvents : 0.0) << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+// 默认使用与基准测试同目录的驱动程序
+std::string defaultDriverPath() {
+    std::error_code error;
+    std::filesystem::path self = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (error) {
+        return "./tourbox_driver";
+    }
+    return (self.parent_path() / "tourbox_driver").string();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string driverPath = argc > 1 ? argv[1] : defaultDriverPath();
+
+    const std::filesystem::path tempDirectory =
+        std::filesystem::temp_directory_path() / ("tourbox_bench_" + std::to_string(getpid()));
+    std::filesystem::create_directories(tempDirectory);
+    const std::string configPath = (tempDirectory / "config.json").string();
+    std::ofstream(configPath) << kBenchConfig;
+
+    // 伪终端：主端由基准测试写入，从端作为驱动程序的串口
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (masterFd < 0 || grantpt(masterFd) < 0 || unlockpt(masterFd) < 0) {
+        std::cerr << "创建伪终端失败: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    const std::string slavePath = ptsname(masterFd);
+
+    // 保持从端打开并设置为原始模式，避免驱动程序配置串口之前的数据被行规程处理
+    int slaveFd = open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    struct termios raw;
+    tcgetattr(slaveFd, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(slaveFd, TCSANOW, &raw);
+
+    int outputPipe[2];
+    if (pipe2(outputPipe, O_CLOEXEC) < 0) {
+        std::cerr << "创建管道失败: " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        dup2(outputPipe[1], 3);
+        // 不跟踪窗口，测量期间预设不会切换
+        execl(driverPath.c_str(), driverPath.c_str(), "--log-level", "warn", "--window-backend", "none",
+              "--config", configPath.c_str(), "--output", "/dev/fd/3", slavePath.c_str(), static_cast<char*>(nullptr));
+        std::cerr << "启动驱动程序失败: " << driverPath << ": " << strerror(errno) << std::endl;
+        _exit(127);
+    }
+    close(outputPipe[1]);
+
+    EventCollector collector(outputPipe[0]);
+
+    // 收到驱动程序发送的初始化命令说明串口已经配置好
+    size_t initBytes = 0;
+    const auto startupDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (initBytes < kInitCommandLength && std::chrono::steady_clock::now() < startupDeadline) {
+        struct pollfd pfd = {masterFd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) > 0) {
+            char buffer[256];
+            ssize_t bytesRead = read(masterFd, buffer, sizeof(buffer));
+            if (bytesRead > 0) {
+                initBytes += static_cast<size_t>(bytesRead);
+            }
+        }
+    }
+    if (initBytes < kInitCommandLength) {
+        std::cerr << "驱动程序没有在 5 秒内完成启动" << std::endl;
+        kill(child, SIGTERM);
+        waitpid(child, nullptr, 0);
+        std::filesystem::remove_all(tempDirectory);
+        return 1;
+    }
+
+    // 预热：确认事件循环已经开始处理串口数据
+    const uint8_t warmup[] = {0x80, 0x00};
+    write(masterFd, warmup, sizeof(warmup));
+    collector.waitFor(2, isKeyEvent, std::chrono::milliseconds(2000));
+
+    const Scenario scenarios[] = {
+        {"按钮风暴 2kHz", makeButtonStorm(4000), 2000.0, isKeyEvent, 0},
+        {"转盘 1kHz", std::vector<uint8_t>(2000, 0x4F), 1000.0, isKeyPress, 0},
+        {"滚轮 1kHz", std::vector<uint8_t>(2000, 0x49), 1000.0, nullptr, -kRelativeStep},
+        {"按钮风暴 (尽快发送)", makeButtonStorm(20000), 0.0, isKeyEvent, 0},
+    };
+    for (const Scenario& scenario : scenarios) {
+        runScenario(masterFd, collector, scenario);
+    }
+
+    kill(child, SIGTERM);
+    int status = 0;
+    waitpid(child, &status, 0);
+    close(masterFd);
+    close(slaveFd);
+    std::filesystem::remove_all(tempDirectory);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
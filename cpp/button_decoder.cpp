@@ -0,0 +1,368 @@
+#include "button_decoder.hpp"
+#include "latency_stats.hpp"
+#include "logger.hpp"
+#include <cmath>
+
+namespace {
+
+struct ControlInfo {
+    uint8_t code;
+    const char* name;
+};
+
+// 有按下和释放两个代码的按钮，释放码为按下码清除最高位
+constexpr ControlInfo kButtons[] = {
+    {0x80, "长键"},
+    {0x81, "侧键"},
+    {0x82, "横键"},
+    {0x83, "短键"},
+    {0x90, "D-Pad 上"},
+    {0x91, "D-Pad 下"},
+    {0x92, "D-Pad 左"},
+    {0x93, "D-Pad 右"},
+    {0x8A, "滚轮单击"},
+    {0xAA, "Tour 按钮"},
+    {0xA2, "C1 按钮"},
+    {0xA3, "C2 按钮"},
+    {0xB7, "旋钮单击"},
+    {0xB8, "转盘单击"},
+};
+
+struct RotationInfo {
+    uint8_t code;
+    const char* name;
+    RotationAxis axis;
+    int8_t direction;
+};
+
+// 只有一个代码的转动事件
+constexpr RotationInfo kRotations[] = {
+    {0x4F, "转盘顺时针", RotationAxis::Dial, 1},
+    {0x0F, "转盘逆时针", RotationAxis::Dial, -1},
+    {0x49, "滚轮上滚动", RotationAxis::Wheel, 1},
+    {0x09, "滚轮下滚动", RotationAxis::Wheel, -1},
+    {0x44, "旋钮顺时针", RotationAxis::Knob, 1},
+    {0x04, "旋钮逆时针", RotationAxis::Knob, -1},
+};
+
+constexpr std::array<ByteClass, 256> kByteClasses = [] {
+    std::array<ByteClass, 256> table{};
+    for (size_t code = 0; code < table.size(); ++code) {
+        table[code].button = static_cast<uint8_t>(code);
+    }
+    for (const ControlInfo& button : kButtons) {
+        table[button.code] = {ByteKind::Press, button.code, button.name, RotationAxis::Knob, 0};
+        table[button.code & 0x7F] = {ByteKind::Release, button.code, button.name, RotationAxis::Knob, 0};
+    }
+    for (const RotationInfo& rotation : kRotations) {
+        table[rotation.code] = {ByteKind::Tap, rotation.code, rotation.name, rotation.axis, rotation.direction};
+    }
+    return table;
+}();
+
+} // namespace
+
+// 平均每帧合并了多少次移动
+double DecoderStats::coalescingRatio() const {
+    if (relativeFrames == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(relativeSteps) / static_cast<double>(relativeFrames);
+}
+
+// 输出统计信息
+void DecoderStats::print() const {
+    LOG_INFO("鼠标移动合并统计: %llu 次移动, 写出 %llu 帧, 合并比 %.2f, 相互抵消 %llu 次",
+             static_cast<unsigned long long>(relativeSteps), static_cast<unsigned long long>(relativeFrames),
+             coalescingRatio(), static_cast<unsigned long long>(cancelledFrames));
+}
+
+ButtonDecoder::ButtonDecoder(const ConfigManager& configManager, UinputWriter& writer, ReleaseScheduler& scheduler,
+                             MacroPlayer& macros, KeyHolderCounts& keyHolders)
+    : m_configManager(configManager), m_writer(writer), m_scheduler(scheduler), m_macros(macros),
+      m_keyHolders(keyHolders) {}
+
+ButtonDecoder::~ButtonDecoder() {
+    if (m_loop) {
+        m_loop->cancelTimer(m_coalesceTimer);
+    }
+}
+
+// 查询字节类别
+const ByteClass& ButtonDecoder::classify(uint8_t code) {
+    return kByteClasses[code];
+}
+
+// 解码一个字节
+void ButtonDecoder::decode(uint8_t code, int presetId, uint64_t timestamp) {
+    const ByteClass& byteClass = kByteClasses[code];
+
+    switch (byteClass.kind) {
+        case ByteKind::Press:
+            LOG_DEBUG("%02X: %s按下", code, byteClass.name);
+            press(byteClass.button, presetId);
+            return;
+        case ByteKind::Release:
+            LOG_DEBUG("%02X: %s释放", code, byteClass.name);
+            release(byteClass.button);
+            return;
+        case ByteKind::Tap:
+            break;
+    }
+
+    m_usedModifiers |= m_modifiers;
+    const ButtonAction& action = lookup(code, presetId);
+    if (action.keyCode == 0) {
+        LOG_DEBUG("%02X: 未映射的按钮代码", code);
+        return;
+    }
+
+    if (byteClass.direction != 0) {
+        rotate(byteClass, action, presetId, timestamp);
+        return;
+    }
+
+    LOG_DEBUG("%02X: %s", code, byteClass.name ? byteClass.name : "未知按钮");
+
+    // 协议之外的代码：鼠标移动累积到本批次末尾，按键立即按下并交给调度器延迟释放
+    if (isRelativeMapping(action.keyCode)) {
+        addMotion(action.keyCode, kRelativeStep);
+    } else {
+        flushMotion();
+        tap(action);
+    }
+}
+
+// 按当前修饰按钮查找映射，开启计时时累计耗时
+const ButtonAction& ButtonDecoder::lookup(uint8_t code, int presetId) {
+    if (!m_timeLookups) {
+        return m_configManager.getAction(code, presetId, m_modifiers);
+    }
+    const uint64_t start = monotonicNanoseconds();
+    const ButtonAction& action = m_configManager.getAction(code, presetId, m_modifiers);
+    m_lookupNanoseconds += monotonicNanoseconds() - start;
+    return action;
+}
+
+// 点按映射的按键或播放宏
+void ButtonDecoder::tap(const ButtonAction& action) {
+    if (action.keyCode == MACRO_ACTION) {
+        m_macros.play(m_configManager.getMacro(action.macroId));
+    } else {
+        m_scheduler.tap(action.keyCode, std::chrono::milliseconds(action.holdMs));
+    }
+}
+
+// 转动没有释放码：按转动速度放大后点按映射的按键或移动鼠标
+void ButtonDecoder::rotate(const ByteClass& byteClass, const ButtonAction& action, int presetId, uint64_t timestamp) {
+    const size_t axis = static_cast<size_t>(byteClass.axis);
+    const double multiplier = m_acceleration.onDetent(byteClass.axis, byteClass.direction, timestamp,
+                                                      m_configManager.getAcceleration(presetId)[axis]);
+
+    LOG_DEBUG("%02X: %s x%.2f", byteClass.button, byteClass.name, multiplier);
+
+    if (isRelativeMapping(action.keyCode)) {
+        addMotion(action.keyCode, static_cast<int>(std::lround(kRelativeStep * multiplier)));
+        return;
+    }
+
+    flushMotion();
+
+    // 按键只能整数次点按，小数部分留到同一控件的下一次转动；慢速转动时不累积
+    double& remainder = m_repeatRemainders[axis];
+    remainder = multiplier > 1.0 ? remainder + multiplier : 1.0;
+    const int repeat = static_cast<int>(remainder);
+    remainder -= repeat;
+
+    for (int i = 0; i < repeat; ++i) {
+        tap(action);
+    }
+}
+
+// 按钮按下：按住映射的按键直到收到释放码
+void ButtonDecoder::press(uint8_t button, int presetId) {
+    const size_t index = button & 0x7F;
+    const uint8_t modifierBit = chordModifierBit(button);
+
+    // 丢失了释放码时再次按下，先释放上一次按住的按键
+    if (m_heldButtons[index] || (m_modifiers & modifierBit)) {
+        m_usedModifiers |= modifierBit;
+        release(button);
+    }
+
+    // 按住其他修饰按钮时查对应的和弦层
+    m_usedModifiers |= m_modifiers;
+    const ButtonAction& action = lookup(button, presetId);
+    m_modifiers |= modifierBit;
+
+    // 在和弦中用作修饰的按钮先不输出，松开时再决定是否触发
+    if (modifierBit & m_configManager.getChordModifiers(presetId)) {
+        m_deferredModifiers |= modifierBit;
+        m_usedModifiers &= static_cast<uint8_t>(~modifierBit);
+        m_deferredActions[button & 0x03] = action;
+        return;
+    }
+
+    if (action.keyCode == 0) {
+        LOG_DEBUG("%02X: 未映射的按钮代码", button);
+        return;
+    }
+
+    // 鼠标移动没有按住的状态，只在按下时移动一次
+    if (isRelativeMapping(action.keyCode)) {
+        addMotion(action.keyCode, kRelativeStep);
+        return;
+    }
+    // 宏在按下时完整播放一次，释放时什么也不做
+    if (action.keyCode == MACRO_ACTION) {
+        flushMotion();
+        tap(action);
+        return;
+    }
+    if (action.keyCode < 0 || action.keyCode >= KEY_CNT) {
+        return;
+    }
+
+    flushMotion();
+
+    const uint16_t keyCode = static_cast<uint16_t>(action.keyCode);
+    m_heldButtons[index] = true;
+    m_heldKeyCodes[index] = keyCode;
+    if (m_keyHolders[keyCode]++ == 0) {
+        generateKeyEvent(m_writer, keyCode, 1);
+    }
+}
+
+// 按钮释放：释放按下时记录的键码，即使期间切换了预设也不会松开错误的按键
+void ButtonDecoder::release(uint8_t button) {
+    const uint8_t modifierBit = chordModifierBit(button);
+    m_modifiers &= static_cast<uint8_t>(~modifierBit);
+
+    if (m_deferredModifiers & modifierBit) {
+        m_deferredModifiers &= static_cast<uint8_t>(~modifierBit);
+        if (!(m_usedModifiers & modifierBit)) {
+            trigger(m_deferredActions[button & 0x03]);
+        }
+        return;
+    }
+
+    releaseKey(button & 0x7F);
+}
+
+// 松开没有参与和弦的修饰按钮时触发它自己的映射
+void ButtonDecoder::trigger(const ButtonAction& action) {
+    if (action.keyCode == 0) {
+        return;
+    }
+    if (isRelativeMapping(action.keyCode)) {
+        addMotion(action.keyCode, kRelativeStep);
+        return;
+    }
+    flushMotion();
+    tap(action);
+}
+
+// 释放按钮按住的按键
+void ButtonDecoder::releaseKey(size_t index) {
+    if (!m_heldButtons[index]) {
+        return;
+    }
+
+    m_heldButtons[index] = false;
+    flushMotion();
+    const uint16_t keyCode = m_heldKeyCodes[index];
+    if (--m_keyHolders[keyCode] == 0) {
+        generateKeyEvent(m_writer, keyCode, 0);
+    }
+}
+
+// 释放所有按住的按键
+// 修饰位掩码反映的是按钮的物理状态，保持不变；推迟的修饰按钮映射不再触发
+void ButtonDecoder::releaseAll() {
+    flushMotion();
+    m_usedModifiers |= m_deferredModifiers;
+    if (m_heldButtons.none()) {
+        return;
+    }
+
+    for (size_t index = 0; index < m_heldButtons.size(); ++index) {
+        releaseKey(index);
+    }
+}
+
+// 累积一次鼠标移动
+void ButtonDecoder::addMotion(int keyCode, int distance) {
+    if (keyCode == REL_X_POS) {
+        m_motionX += distance;
+    } else if (keyCode == REL_X_NEG) {
+        m_motionX -= distance;
+    } else if (keyCode == REL_Y_POS) {
+        m_motionY += distance;
+    } else if (keyCode == REL_Y_NEG) {
+        m_motionY -= distance;
+    } else {
+        return;
+    }
+    m_stats.relativeSteps++;
+    m_motionPending = true;
+}
+
+// 写出累积的鼠标移动，两个轴共用一个 SYN_REPORT
+void ButtonDecoder::flushMotion() {
+    if (!m_motionPending) {
+        return;
+    }
+    m_motionPending = false;
+
+    if (m_coalesceTimer != EventLoop::kInvalidTimer) {
+        m_loop->cancelTimer(m_coalesceTimer);
+        m_coalesceTimer = EventLoop::kInvalidTimer;
+    }
+
+    if (m_motionX == 0 && m_motionY == 0) {
+        m_stats.cancelledFrames++;
+        return;
+    }
+
+    if (m_motionX != 0) {
+        m_writer.append(EV_REL, REL_X, m_motionX);
+    }
+    if (m_motionY != 0) {
+        m_writer.append(EV_REL, REL_Y, m_motionY);
+    }
+    m_writer.sync();
+    m_stats.relativeFrames++;
+
+    m_motionX = 0;
+    m_motionY = 0;
+}
+
+// 一批字节解码完毕
+void ButtonDecoder::endBatch() {
+    if (!m_motionPending) {
+        return;
+    }
+
+    if (!m_loop || m_coalesceWindow.count() == 0) {
+        flushMotion();
+        return;
+    }
+
+    // 时间窗从第一次移动开始计算，期间到达的移动都合并进同一帧
+    if (m_coalesceTimer == EventLoop::kInvalidTimer) {
+        m_coalesceTimer = m_loop->addTimer(m_coalesceWindow, [this]() {
+            m_coalesceTimer = EventLoop::kInvalidTimer;
+            flushMotion();
+            m_writer.flush();
+        });
+        if (m_coalesceTimer == EventLoop::kInvalidTimer) {
+            flushMotion();
+        }
+    }
+}
+
+// 设置鼠标移动的合并时间窗
+void ButtonDecoder::setCoalesceWindow(EventLoop& loop, std::chrono::microseconds window) {
+    m_loop = &loop;
+    m_coalesceWindow = window;
+}
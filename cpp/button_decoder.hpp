@@ -0,0 +1,146 @@
+#ifndef BUTTON_DECODER_HPP
+#define BUTTON_DECODER_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <linux/input-event-codes.h>
+#include <utility>
+#include "acceleration.hpp"
+#include "config_manager.hpp"
+#include "event_loop.hpp"
+#include "macro.hpp"
+#include "release_scheduler.hpp"
+#include "uinput_helper.hpp"
+
+// 串口字节的类别
+enum class ByteKind : uint8_t {
+    Tap,      // 没有释放码的瞬时事件（旋钮、转盘、滚轮转动）以及协议之外的代码
+    Press,    // 按钮按下，最高位为 1
+    Release   // 按钮释放，按下码清除最高位
+};
+
+struct ByteClass {
+    ByteKind kind = ByteKind::Tap;
+    uint8_t button = 0;          // 按下和释放都记为对应的按下码，用作按钮编号
+    const char* name = nullptr;  // 控件名称，仅用于调试输出
+    RotationAxis axis = RotationAxis::Knob;
+    int8_t direction = 0;        // 转动方向 +1/-1，0 表示不是转动
+};
+
+// 鼠标移动合并统计
+struct DecoderStats {
+    uint64_t relativeSteps = 0;    // 解码出的鼠标移动次数（每个转动刻度或方向键按下一次）
+    uint64_t relativeFrames = 0;   // 实际写出的 EV_REL 帧数
+    uint64_t cancelledFrames = 0;  // 正反方向相互抵消、无需写出的批次
+
+    // 平均每帧合并了多少次移动
+    double coalescingRatio() const;
+
+    // 输出统计信息
+    void print() const;
+};
+
+// 每个键码被几个按钮按住，多个按钮映射同一个键时最后一个松开才释放
+// 由输出通道持有：共用一个输出的多台设备写的是同一个虚拟设备，计数也必须共用
+using KeyHolderCounts = std::array<uint16_t, KEY_CNT>;
+
+// 按钮解码状态机
+// 每个字节先查 256 项分类表：按下时输出 EV_KEY 1 并记录按住的按键，释放时输出 EV_KEY 0，
+// 这样映射为修饰键的按钮可以真正按住；转动等瞬时事件仍交给释放调度器按 hold_ms 点按，
+// 并根据转动速度按预设的加速曲线放大为多次点按或更远的鼠标移动。
+// 鼠标移动不会逐个写出：同一批字节（或合并时间窗内）同一轴的移动累加为一个 EV_REL，
+// 正反方向相互抵消，所有轴共用一个 SYN_REPORT；写出按键事件前会先写出之前累积的移动以保持顺序。
+// 映射为宏的按钮在按下（或每次点按）时交给宏播放器，不记录按住状态。
+// 长键、侧键、横键、短键按住时记录在修饰位掩码中，查表时作为和弦层的下标；
+// 在当前预设的和弦中用作修饰的按钮按下时不输出，松开时如果期间没有其他输入才点按它自己的映射
+class ButtonDecoder {
+public:
+    ButtonDecoder(const ConfigManager& configManager, UinputWriter& writer, ReleaseScheduler& scheduler,
+                  MacroPlayer& macros, KeyHolderCounts& keyHolders);
+    ~ButtonDecoder();
+
+    ButtonDecoder(const ButtonDecoder&) = delete;
+    ButtonDecoder& operator=(const ButtonDecoder&) = delete;
+
+    // 查询字节类别
+    static const ByteClass& classify(uint8_t code);
+
+    // 解码一个字节，事件追加到写入器，由调用者负责 flush
+    // timestamp 为读到该字节时的单调时钟纳秒数，用于估算转动速度
+    void decode(uint8_t code, int presetId, uint64_t timestamp);
+
+    // 一批字节解码完毕：写出累积的鼠标移动，或在设置了合并时间窗时等到时间窗结束再写出
+    void endBatch();
+
+    // 设置鼠标移动的合并时间窗，0 表示只合并同一次读取到的字节
+    void setCoalesceWindow(EventLoop& loop, std::chrono::microseconds window);
+
+    // 释放所有按住的按键（切换预设或退出时调用），由调用者负责 flush
+    void releaseAll();
+
+    const DecoderStats& stats() const { return m_stats; }
+
+    // 当前按住的按钮数量
+    size_t heldCount() const { return m_heldButtons.count(); }
+
+    // 当前按住的修饰按钮位掩码
+    uint8_t modifiers() const { return m_modifiers; }
+
+    // 开启后累计查找映射的耗时（每次查找读两次时钟），用于延迟统计
+    void setLookupTiming(bool enabled) { m_timeLookups = enabled; }
+
+    // 取出上次调用以来查找映射的累计纳秒数
+    uint64_t takeLookupNanoseconds() { return std::exchange(m_lookupNanoseconds, 0); }
+
+private:
+    // 按当前修饰按钮查找映射
+    const ButtonAction& lookup(uint8_t code, int presetId);
+
+    void press(uint8_t button, int presetId);
+    void release(uint8_t button);
+
+    // 释放按钮按住的按键
+    void releaseKey(size_t index);
+
+    // 松开没有参与和弦的修饰按钮时触发它自己的映射
+    void trigger(const ButtonAction& action);
+    void rotate(const ByteClass& byteClass, const ButtonAction& action, int presetId, uint64_t timestamp);
+
+    // 点按映射的按键或播放宏
+    void tap(const ButtonAction& action);
+
+    // 累积一次鼠标移动
+    void addMotion(int keyCode, int distance);
+
+    // 写出累积的鼠标移动
+    void flushMotion();
+
+    const ConfigManager& m_configManager;
+    UinputWriter& m_writer;
+    ReleaseScheduler& m_scheduler;
+    MacroPlayer& m_macros;
+    KeyHolderCounts& m_keyHolders;  // 与写到同一输出的其他解码器共用
+    AccelerationEngine m_acceleration;
+    std::array<double, kRotationAxisCount> m_repeatRemainders{};  // 加速倍数的小数部分累积到下一次点按
+
+    int m_motionX = 0;
+    int m_motionY = 0;
+    bool m_motionPending = false;
+    EventLoop* m_loop = nullptr;
+    std::chrono::microseconds m_coalesceWindow{0};
+    EventLoop::TimerId m_coalesceTimer = EventLoop::kInvalidTimer;
+    DecoderStats m_stats;
+    bool m_timeLookups = false;
+    uint64_t m_lookupNanoseconds = 0;
+
+    std::bitset<128> m_heldButtons;              // 以按钮编号的低 7 位为下标
+    std::array<uint16_t, 128> m_heldKeyCodes{};  // 按下时映射到的键码，释放时使用同一个键码
+
+    uint8_t m_modifiers = 0;          // 按住的修饰按钮
+    uint8_t m_deferredModifiers = 0;  // 按下时推迟了自己映射的修饰按钮
+    uint8_t m_usedModifiers = 0;      // 按住期间有过其他输入的修饰按钮，松开时不再触发自己的映射
+    std::array<ButtonAction, kChordModifierCount> m_deferredActions{};  // 以修饰位下标为下标
+};
+
+#endif // BUTTON_DECODER_HPP
@@ -1,24 +1,80 @@
 #include "config_manager.hpp"
 #include "uinput_helper.hpp"
+#include "logger.hpp"
 #include <filesystem>
 #include <fstream>
-#include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <bit>
 
 // WindowRule 方法实现
-bool WindowRule::matches(const std::string& activeClass, const std::string& activeTitle) const {
-    if (!windowClass.empty() && windowClass != activeClass) {
+bool WindowRule::matches(std::string_view activeClass, std::string_view activeTitle) const {
+    if (classMatcher && !classMatcher->matches(activeClass)) {
         return false;
     }
-    if (!windowTitle.empty() && activeTitle.find(windowTitle) == std::string::npos) {
+    if (titleMatcher && !titleMatcher->matches(activeTitle)) {
         return false;
     }
     return true;
 }
 
+// 查找预设 id
+int CompiledConfig::findPresetId(const std::string& presetName) const {
+    auto it = presetIds.find(presetName);
+    if (it == presetIds.end()) {
+        return ConfigManager::kDefaultPresetId;
+    }
+    return it->second;
+}
+
+// 所有预设中用到的键码
+std::vector<int> CompiledConfig::keyCodes() const {
+    std::vector<int> keyCodes;
+    std::map<int, bool> uniqueKeyCodes;
+
+    auto addKeyCode = [&](int keyCode) {
+        // 跳过无映射和已经添加过的键码
+        if (keyCode != 0 && keyCode != MACRO_ACTION && uniqueKeyCodes.find(keyCode) == uniqueKeyCodes.end()) {
+            uniqueKeyCodes[keyCode] = true;
+            keyCodes.push_back(keyCode);
+        }
+    };
+
+    // 收集所有预设和宏中使用的键码
+    for (const auto& table : presetTables) {
+        for (const auto& layer : table) {
+            for (const auto& action : layer) {
+                addKeyCode(action.keyCode);
+            }
+        }
+    }
+    for (const auto& macro : macros) {
+        for (int keyCode : macro.keyCodes) {
+            addKeyCode(keyCode);
+        }
+    }
+
+    return keyCodes;
+}
+
+namespace {
+
+// 只有 "default" 预设且没有任何映射的配置
+std::unique_ptr<const CompiledConfig> makeEmptyConfig() {
+    auto config = std::make_unique<CompiledConfig>();
+    config->presetNames.assign(1, "default");
+    config->presetTables.assign(1, ChordTable());
+    config->chordModifiers.assign(1, 0);
+    config->accelerationProfiles.assign(1, AccelerationProfile());
+    config->presetIds["default"] = ConfigManager::kDefaultPresetId;
+    return config;
+}
+
+} // namespace
+
 // ConfigManager 构造函数
 ConfigManager::ConfigManager(const std::string& configPath)
-    : m_configPath(configPath), m_activePreset("default") {
+    : m_configPath(configPath), m_config(makeEmptyConfig()) {
     // 展开 ~ 到用户主目录
     if (m_configPath.find("~") == 0) {
         const char* homeDir = getenv("HOME");
@@ -31,117 +87,598 @@ ConfigManager::ConfigManager(const std::string& configPath)
     loadConfig();
 }
 
-// 加载配置文件
+// 加载配置文件并立即发布
 bool ConfigManager::loadConfig() {
+    if (!std::filesystem::exists(m_configPath)) {
+        LOG_WARN("无法打开配置文件，使用默认配置");
+        createDefaultConfig();
+    }
+
+    std::unique_ptr<CompiledConfig> config = parseConfig();
+    if (!config) {
+        return false;
+    }
+    publish(std::move(config));
+    return true;
+}
+
+// 解析并编译配置文件
+std::unique_ptr<CompiledConfig> ConfigManager::parseConfig() const {
     try {
         std::ifstream configFile(m_configPath);
         if (!configFile.is_open()) {
-            std::cerr << "无法打开配置文件，使用默认配置" << std::endl;
-            createDefaultConfig();
-            return false;
+            LOG_ERROR("无法打开配置文件: %s", m_configPath.c_str());
+            return nullptr;
         }
 
-		std::cerr<<"正在加载配置文件: "<<m_configPath<<std::endl;
+        LOG_INFO("正在加载配置文件: %s", m_configPath.c_str());
 
         json config;
         configFile >> config;
 
-        // 加载预设
+        auto compiled = std::make_unique<CompiledConfig>();
+
+        // 加载预设，"default" 总是占用 id 0
+        std::vector<KeyMapping> presets(1);
+        compiled->presetNames.assign(1, "default");
+        compiled->presetIds["default"] = kDefaultPresetId;
+
         for (auto& [presetName, mappings] : config["presets"].items()) {
             KeyMapping keyMapping;
 
-            for (auto& [buttonCode, keyCode] : mappings.items()) {
-                // 将十六进制字符串转换为整数
-                uint8_t code = std::stoi(buttonCode, nullptr, 16);
-
-                // 如果键值是字符串，查找对应的键码
-                if (keyCode.is_string()) {
-                    std::string keyName = keyCode;
-                    if (m_keyNameMap.find(keyName) != m_keyNameMap.end()) {
-                        keyMapping[code] = m_keyNameMap[keyName];
-                    } else {
-                        std::cerr << "未知键名: " << keyName << std::endl;
-                    }
-                } else if (keyCode.is_number()) {
-                    keyMapping[code] = keyCode;
+            for (auto& [buttonCode, value] : mappings.items()) {
+                uint16_t key = 0;
+                if (!parseButtonKey(buttonCode, key)) {
+                    continue;
+                }
+
+                ButtonAction action;
+                if (parseAction(value, action, *compiled)) {
+                    keyMapping[key] = action;
+                }
+            }
+
+            auto [it, inserted] = compiled->presetIds.try_emplace(presetName,
+                                                                  static_cast<int>(compiled->presetNames.size()));
+            if (inserted) {
+                compiled->presetNames.push_back(presetName);
+                presets.push_back(KeyMapping());
+            }
+            presets[it->second] = keyMapping;
+        }
+
+        compilePresets(presets, *compiled);
+
+        // 加载加速曲线，未配置的预设沿用 "default" 的曲线
+        std::vector<AccelerationProfile> profiles(compiled->presetNames.size());
+        std::vector<bool> configured(compiled->presetNames.size(), false);
+        if (config.contains("acceleration")) {
+            for (auto& [presetName, value] : config["acceleration"].items()) {
+                auto it = compiled->presetIds.find(presetName);
+                if (it == compiled->presetIds.end()) {
+                    LOG_WARN("加速曲线对应的预设不存在: %s", presetName.c_str());
+                    continue;
                 }
+                configured[it->second] = parseAccelerationProfile(value, profiles[it->second]);
+            }
+        }
+        for (size_t presetId = 1; presetId < profiles.size(); ++presetId) {
+            if (!configured[presetId]) {
+                profiles[presetId] = profiles[kDefaultPresetId];
             }
+        }
+        compiled->accelerationProfiles = std::move(profiles);
 
-            m_presets[presetName] = keyMapping;
+        // 加载每台设备的预设替换
+        if (config.contains("devices")) {
+            for (auto& [devicePath, value] : config["devices"].items()) {
+                std::vector<int> presetMap;
+                if (parseDevicePresets(value, *compiled, presetMap)) {
+                    compiled->devicePresetMaps[devicePath] = std::move(presetMap);
+                }
+            }
         }
 
+        // 鼠标移动合并时间窗，上限 50ms，再长会明显感觉到延迟
+        compiled->coalesceWindow = std::chrono::microseconds(std::clamp(config.value("coalesce_window_us", 0), 0, 50000));
+
         // 加载窗口规则
-        m_windowRules.clear();
         for (auto& rule : config["window_rules"]) {
             WindowRule windowRule;
-            windowRule.windowClass = rule.value("class", "");
-            windowRule.windowTitle = rule.value("title", "");
-            windowRule.presetName = rule.value("preset", "default");
+            if (!parseWindowRule(rule, *compiled, windowRule)) {
+                LOG_WARN("忽略窗口规则: %s", rule.dump().c_str());
+                continue;
+            }
+            compiled->windowRules.push_back(std::move(windowRule));
+        }
+
+        return compiled;
+    } catch (const std::exception& e) {
+        LOG_ERROR("加载配置文件失败: %s", e.what());
+        return nullptr;
+    }
+}
+
+// 发布新配置
+void ConfigManager::publish(std::unique_ptr<const CompiledConfig> config) {
+    m_config.publish(std::move(config));
+    m_ruleCache.clear();
+}
+
+// 根据窗口信息解析预设 id
+int ConfigManager::resolvePresetId(const InternedString& windowClass, const InternedString& windowTitle) {
+    const uint64_t classHash = windowClass.hash;
+    const uint64_t cacheKey = classHash ^ (windowTitle.hash + 0x9e3779b97f4a7c15ull + (classHash << 6) + (classHash >> 2));
+
+    auto cached = m_ruleCache.find(cacheKey);
+    if (cached != m_ruleCache.end() && cached->second.windowClassId == windowClass.id
+        && cached->second.windowTitleId == windowTitle.id) {
+        return cached->second.presetId;
+    }
+
+    int presetId = kDefaultPresetId;
+    for (const auto& rule : config().windowRules) {
+        if (rule.matches(windowClass.text, windowTitle.text)) {
+            presetId = rule.presetId;
+            break;
+        }
+    }
+
+    // 浏览器等窗口的标题会不断变化，缓存满时整体清空以限制内存占用
+    if (cached == m_ruleCache.end() && m_ruleCache.size() >= kRuleCacheCapacity) {
+        m_ruleCache.clear();
+    }
+    m_ruleCache[cacheKey] = RuleCacheEntry{windowClass.id, windowTitle.id, presetId};
+    return presetId;
+}
+
+// 获取预设名称
+const std::string& ConfigManager::getPresetName(int presetId) const {
+    const CompiledConfig& current = config();
+    if (presetId < 0 || static_cast<size_t>(presetId) >= current.presetNames.size()) {
+        return current.presetNames[kDefaultPresetId];
+    }
+    return current.presetNames[presetId];
+}
+
+// 解析一个映射值
+bool ConfigManager::parseAction(const json& value, ButtonAction& action, CompiledConfig& compiled) const {
+    const json* keyValue = &value;
+
+    // 对象形式可以额外指定按键保持时间
+    if (value.is_object()) {
+        int holdMs = value.value("hold_ms", static_cast<int>(ButtonAction::kDefaultHoldMs));
+        action.holdMs = static_cast<uint16_t>(std::clamp(holdMs, 0, 60000));
+
+        if (value.contains("macro")) {
+            // 宏默认不保持，整个组合键在一次写入中完成
+            Macro macro;
+            if (!parseMacro(value["macro"], static_cast<uint16_t>(std::clamp(value.value("hold_ms", 0), 0, 60000)), macro)) {
+                return false;
+            }
+            return addMacro(std::move(macro), action, compiled);
+        }
+
+        if (!value.contains("key")) {
+            LOG_WARN("映射缺少 \"key\" 或 \"macro\" 字段: %s", value.dump().c_str());
+            return false;
+        }
+        keyValue = &value["key"];
+    }
+
+    // 如果键值是字符串，查找对应的键码
+    if (keyValue->is_string()) {
+        const std::string keyName = *keyValue;
 
-            m_windowRules.push_back(windowRule);
+        // "KEY_LEFTCTRL+KEY_Z" 是只有一步的宏
+        if (keyName.find('+') != std::string::npos) {
+            Macro macro;
+            if (!parseMacro(json::array({keyName}), 0, macro)) {
+                return false;
+            }
+            return addMacro(std::move(macro), action, compiled);
         }
 
+        auto it = m_keyNameMap.find(keyName);
+        if (it == m_keyNameMap.end()) {
+            LOG_WARN("未知键名: %s", keyName.c_str());
+            return false;
+        }
+        action.keyCode = it->second;
         return true;
-    } catch (const std::exception& e) {
-        std::cerr << "加载配置文件失败: " << e.what() << std::endl;
+    }
+
+    if (keyValue->is_number()) {
+        action.keyCode = *keyValue;
+        return true;
+    }
+
+    return false;
+}
+
+// 把编译好的宏加入配置，并让动作指向它
+bool ConfigManager::addMacro(Macro macro, ButtonAction& action, CompiledConfig& compiled) {
+    if (compiled.macros.size() >= ButtonAction::kNoMacro) {
+        LOG_WARN("宏数量过多，忽略");
         return false;
     }
+    action.keyCode = MACRO_ACTION;
+    action.macroId = static_cast<uint16_t>(compiled.macros.size());
+    compiled.macros.push_back(std::move(macro));
+    return true;
 }
 
-// 根据窗口信息获取按键映射
-int ConfigManager::getKeyMapping(uint8_t buttonCode, const std::string& windowClass, const std::string& windowTitle) {
-    // 查找匹配的窗口规则
-    std::string presetName = "default";
-    for (const auto& rule : m_windowRules) {
-        if (rule.matches(windowClass, windowTitle)) {
-            presetName = rule.presetName;
-            break;
+// 编译宏
+bool ConfigManager::parseMacro(const json& steps, uint16_t holdMs, Macro& macro) const {
+    if (!steps.is_array() || steps.empty()) {
+        LOG_WARN("宏必须是非空数组: %s", steps.dump().c_str());
+        return false;
+    }
+
+    uint32_t offsetMs = 0;
+
+    // 追加一帧（一个按键事件和 SYN_REPORT），时间不同时开始新的一段
+    auto appendFrame = [&macro](uint32_t frameOffset, uint16_t keyCode, int32_t value) {
+        if (macro.steps.empty() || macro.steps.back().offsetMs != frameOffset) {
+            macro.steps.push_back(MacroStep{frameOffset, static_cast<uint32_t>(macro.events.size()), 0});
         }
+        struct input_event event{};
+        event.type = EV_KEY;
+        event.code = keyCode;
+        event.value = value;
+        macro.events.push_back(event);
+        event.type = EV_SYN;
+        event.code = SYN_REPORT;
+        event.value = 0;
+        macro.events.push_back(event);
+        macro.steps.back().count += 2;
+    };
+
+    for (const auto& step : steps) {
+        if (step.is_object()) {
+            if (!step.contains("delay_ms")) {
+                LOG_WARN("宏步骤缺少 \"delay_ms\" 字段: %s", step.dump().c_str());
+                return false;
+            }
+            offsetMs += static_cast<uint32_t>(std::clamp(step.value("delay_ms", 0), 0, 10000));
+            continue;
+        }
+        if (!step.is_string()) {
+            LOG_WARN("宏步骤必须是组合键字符串或 {\"delay_ms\": ...}: %s", step.dump().c_str());
+            return false;
+        }
+
+        // 拆分组合键
+        std::vector<uint16_t> chord;
+        const std::string text = step;
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find('+', start);
+            if (end == std::string::npos) {
+                end = text.size();
+            }
+            const std::string keyName = text.substr(start, end - start);
+            auto it = m_keyNameMap.find(keyName);
+            if (it == m_keyNameMap.end() || it->second <= 0 || it->second >= KEY_CNT) {
+                LOG_WARN("宏中有未知或不能按下的键名: %s", keyName.c_str());
+                return false;
+            }
+            chord.push_back(static_cast<uint16_t>(it->second));
+            start = end + 1;
+        }
+
+        for (uint16_t keyCode : chord) {
+            appendFrame(offsetMs, keyCode, 1);
+            if (std::find(macro.keyCodes.begin(), macro.keyCodes.end(), keyCode) == macro.keyCodes.end()) {
+                macro.keyCodes.push_back(keyCode);
+            }
+        }
+        offsetMs += holdMs;
+        for (auto it = chord.rbegin(); it != chord.rend(); ++it) {
+            appendFrame(offsetMs, *it, 0);
+        }
+
+        if (macro.events.size() > Macro::kMaxEvents) {
+            LOG_WARN("宏过长，最多 %zu 个事件", Macro::kMaxEvents);
+            return false;
+        }
+    }
+
+    if (macro.events.empty()) {
+        LOG_WARN("宏中没有按键: %s", steps.dump().c_str());
+        return false;
     }
+    return true;
+}
 
-    // 如果预设发生变化，输出提示
-    if (presetName != m_activePreset) {
-        std::cout << "切换到预设: " << presetName << std::endl;
-        m_activePreset = presetName;
+// 解析一条加速曲线，未出现的字段保留 curve 中原有的值
+bool ConfigManager::parseAccelerationCurve(const json& value, AccelerationCurve& curve) const {
+    if (!value.is_object()) {
+        LOG_WARN("加速曲线必须是对象: %s", value.dump().c_str());
+        return false;
     }
 
-    // 查找预设中的按键映射
-    if (m_presets.find(presetName) != m_presets.end()) {
-        const auto& mapping = m_presets[presetName];
-        if (mapping.find(buttonCode) != mapping.end()) {
-            return mapping.at(buttonCode);
+    if (value.contains("curve")) {
+        const std::string type = value.value("curve", "none");
+        if (type == "none") {
+            curve.type = AccelerationCurve::Type::None;
+        } else if (type == "linear") {
+            curve.type = AccelerationCurve::Type::Linear;
+        } else if (type == "exponential") {
+            curve.type = AccelerationCurve::Type::Exponential;
+        } else if (type == "points") {
+            curve.type = AccelerationCurve::Type::Points;
+        } else {
+            LOG_WARN("未知的加速曲线类型: %s", type.c_str());
+            return false;
         }
     }
 
-    // 如果没有找到映射，使用默认预设
-    if (presetName != "default" && m_presets.find("default") != m_presets.end()) {
-        const auto& defaultMapping = m_presets["default"];
-        if (defaultMapping.find(buttonCode) != defaultMapping.end()) {
-            return defaultMapping.at(buttonCode);
+    curve.threshold = std::max(0.0, value.value("threshold", curve.threshold));
+    curve.gain = std::max(0.0, value.value("gain", curve.gain));
+    curve.exponent = std::max(0.0, value.value("exponent", curve.exponent));
+    curve.maxMultiplier = std::clamp(value.value("max", curve.maxMultiplier), 1.0, 50.0);
+
+    if (value.contains("points")) {
+        curve.points.clear();
+        for (const auto& point : value["points"]) {
+            if (!point.is_array() || point.size() != 2 || !point[0].is_number() || !point[1].is_number()) {
+                LOG_WARN("加速曲线的点必须是 [速度, 倍数]: %s", point.dump().c_str());
+                continue;
+            }
+            curve.points.emplace_back(point[0].get<double>(), point[1].get<double>());
         }
+        std::sort(curve.points.begin(), curve.points.end());
     }
 
-    // 如果还是没有找到，返回0（无映射）
-    return 0;
+    if (curve.type == AccelerationCurve::Type::Points && curve.points.empty()) {
+        LOG_WARN("points 加速曲线没有有效的点，不加速");
+        curve.type = AccelerationCurve::Type::None;
+    }
+    return true;
 }
 
-// 获取所有需要注册的键码
-std::vector<int> ConfigManager::getAllKeyCodes() const {
-    std::vector<int> keyCodes;
-    std::map<int, bool> uniqueKeyCodes;
+// 解析一个预设的加速配置
+bool ConfigManager::parseAccelerationProfile(const json& value, AccelerationProfile& profile) const {
+    AccelerationCurve base;
+    if (!parseAccelerationCurve(value, base)) {
+        return false;
+    }
+    profile.fill(base);
 
-    // 收集所有预设中使用的键码
-    for (const auto& [presetName, mapping] : m_presets) {
-        for (const auto& [buttonCode, keyCode] : mapping) {
-            // 跳过已经添加过的键码
-            if (uniqueKeyCodes.find(keyCode) == uniqueKeyCodes.end()) {
-                uniqueKeyCodes[keyCode] = true;
-                keyCodes.push_back(keyCode);
+    static const std::pair<const char*, RotationAxis> kAxisNames[] = {
+        {"knob", RotationAxis::Knob},
+        {"dial", RotationAxis::Dial},
+        {"wheel", RotationAxis::Wheel},
+    };
+    for (const auto& [axisName, axis] : kAxisNames) {
+        if (value.contains(axisName)) {
+            AccelerationCurve curve = base;
+            if (parseAccelerationCurve(value[axisName], curve)) {
+                profile[static_cast<size_t>(axis)] = std::move(curve);
             }
         }
     }
+    return true;
+}
+
+// 设备的预设映射表
+std::vector<int> ConfigManager::getDevicePresetMap(const std::string& path) const {
+    const CompiledConfig& compiled = config();
+    if (compiled.devicePresetMaps.empty()) {
+        return {};
+    }
+
+    std::error_code error;
+    const std::filesystem::path devicePath = std::filesystem::canonical(path, error);
+    for (const auto& [configuredPath, presetMap] : compiled.devicePresetMaps) {
+        if (configuredPath == path) {
+            return presetMap;
+        }
+        const std::filesystem::path resolved = std::filesystem::canonical(configuredPath, error);
+        if (!error && resolved == devicePath) {
+            return presetMap;
+        }
+    }
+    return {};
+}
 
-    return keyCodes;
+// 解析一台设备的预设替换
+bool ConfigManager::parseDevicePresets(const json& value, const CompiledConfig& compiled,
+                                       std::vector<int>& presetMap) {
+    if (!value.is_object()) {
+        LOG_WARN("设备配置应为对象: %s", value.dump().c_str());
+        return false;
+    }
+
+    auto findPreset = [&](const json& name, int& presetId) {
+        auto it = name.is_string() ? compiled.presetIds.find(name.get<std::string>()) : compiled.presetIds.end();
+        if (it == compiled.presetIds.end()) {
+            LOG_WARN("设备配置中的预设不存在: %s", name.dump().c_str());
+            return false;
+        }
+        presetId = it->second;
+        return true;
+    };
+
+    presetMap.resize(compiled.presetNames.size());
+    for (size_t presetId = 0; presetId < presetMap.size(); ++presetId) {
+        presetMap[presetId] = static_cast<int>(presetId);
+    }
+
+    int replacement = 0;
+    if (value.contains("preset") && findPreset(value["preset"], replacement)) {
+        std::fill(presetMap.begin(), presetMap.end(), replacement);
+    }
+    if (value.contains("presets") && value["presets"].is_object()) {
+        for (auto& [presetName, name] : value["presets"].items()) {
+            int presetId = 0;
+            if (findPreset(presetName, presetId) && findPreset(name, replacement)) {
+                presetMap[presetId] = replacement;
+            }
+        }
+    }
+    return true;
+}
+
+// 解析一条窗口规则
+bool ConfigManager::parseWindowRule(const json& value, const CompiledConfig& compiled, WindowRule& rule) {
+    if (!value.is_object()) {
+        LOG_WARN("窗口规则应为对象: %s", value.dump().c_str());
+        return false;
+    }
+
+    const bool caseInsensitive = value.value("case_insensitive", false);
+
+    // 编译一个字段的条件：精确匹配/子串、正则或通配符只能选一种，空字符串视为未设置
+    auto compileField = [&](const std::string& field, bool wholeString, std::optional<PatternMatcher>& matcher) {
+        const std::array<std::string, 3> keys = {field, field + "_regex", field + "_glob"};
+
+        size_t chosen = keys.size();
+        for (size_t index = 0; index < keys.size(); ++index) {
+            const auto it = value.find(keys[index]);
+            if (it == value.end() || !it->is_string() || it->get<std::string>().empty()) {
+                continue;
+            }
+            if (chosen != keys.size()) {
+                LOG_WARN("窗口规则同时设置了 %s 和 %s", keys[chosen].c_str(), keys[index].c_str());
+                return false;
+            }
+            chosen = index;
+        }
+        if (chosen == keys.size()) {
+            return true;
+        }
+
+        const std::string pattern = value[keys[chosen]].get<std::string>();
+        PatternMatcher compiledMatcher;
+        std::string error;
+        bool compiled = false;
+        switch (chosen) {
+            case 0:
+                compiled = PatternMatcher::compileLiteral(pattern, caseInsensitive, wholeString, compiledMatcher, error);
+                break;
+            case 1:
+                compiled = PatternMatcher::compileRegex(pattern, caseInsensitive, compiledMatcher, error);
+                break;
+            default:
+                compiled = PatternMatcher::compileGlob(pattern, caseInsensitive, compiledMatcher, error);
+                break;
+        }
+        if (!compiled) {
+            LOG_WARN("窗口规则的 %s 无效: %s: %s", keys[chosen].c_str(), pattern.c_str(), error.c_str());
+            return false;
+        }
+        matcher = std::move(compiledMatcher);
+        return true;
+    };
+
+    // class 要求类名完全相同，title 只需标题中包含该字符串
+    if (!compileField("class", true, rule.classMatcher) || !compileField("title", false, rule.titleMatcher)) {
+        return false;
+    }
+
+    const std::string presetName = value.value("preset", "default");
+    auto it = compiled.presetIds.find(presetName);
+    if (it == compiled.presetIds.end()) {
+        LOG_WARN("窗口规则对应的预设不存在，使用默认预设: %s", presetName.c_str());
+        rule.presetId = kDefaultPresetId;
+    } else {
+        rule.presetId = it->second;
+    }
+    return true;
+}
+
+// 解析映射的按钮代码
+bool ConfigManager::parseButtonKey(const std::string& text, uint16_t& key) {
+    uint8_t modifiers = 0;
+    size_t start = 0;
+
+    while (true) {
+        const size_t end = text.find('+', start);
+        const std::string part = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        // 将十六进制字符串转换为整数
+        size_t parsed = 0;
+        unsigned long code = 0;
+        try {
+            code = std::stoul(part, &parsed, 16);
+        } catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (part.empty() || parsed != part.size() || code > 0xFF) {
+            LOG_WARN("无效的按钮代码: %s", text.c_str());
+            return false;
+        }
+
+        if (end == std::string::npos) {
+            if (modifiers & chordModifierBit(static_cast<uint8_t>(code))) {
+                LOG_WARN("和弦中的按钮重复: %s", text.c_str());
+                return false;
+            }
+            key = static_cast<uint16_t>((modifiers << 8) | code);
+            return true;
+        }
+
+        const uint8_t bit = chordModifierBit(static_cast<uint8_t>(code));
+        if (bit == 0) {
+            LOG_WARN("和弦 %s 中的 %s 不是修饰按钮，只能使用 80/81/82/83", text.c_str(), part.c_str());
+            return false;
+        }
+        modifiers |= bit;
+        start = end + 1;
+    }
+}
+
+// 将解析出的预设编译为和弦动作表
+void ConfigManager::compilePresets(const std::vector<KeyMapping>& presets, CompiledConfig& config) {
+    config.presetTables.resize(presets.size());
+    config.chordModifiers.assign(presets.size(), 0);
+
+    for (size_t presetId = 0; presetId < presets.size(); ++presetId) {
+        // 先放 "default" 的映射，再用预设自己的映射覆盖，查找时无需再回退
+        KeyMapping merged = presets[kDefaultPresetId];
+        for (const auto& [key, action] : presets[presetId]) {
+            merged[key] = action;
+        }
+
+        ChordTable& table = config.presetTables[presetId];
+        std::vector<std::pair<uint8_t, uint8_t>> chords;  // (修饰位掩码, 按钮代码)
+        for (const auto& [key, action] : merged) {
+            const uint8_t modifiers = static_cast<uint8_t>(key >> 8);
+            if (modifiers == 0) {
+                table[0][key & 0xFF] = action;
+            } else {
+                chords.emplace_back(modifiers, static_cast<uint8_t>(key & 0xFF));
+                config.chordModifiers[presetId] |= modifiers;
+            }
+        }
+
+        // 修饰按钮少的和弦先写入，同时按住更多修饰按钮时更具体的和弦覆盖它们
+        std::stable_sort(chords.begin(), chords.end(), [](const auto& a, const auto& b) {
+            return std::popcount(a.first) < std::popcount(b.first);
+        });
+
+        for (size_t mask = 1; mask < kChordLayerCount; ++mask) {
+            table[mask] = table[0];
+            for (const auto& [modifiers, code] : chords) {
+                if ((modifiers & mask) == modifiers) {
+                    table[mask][code] = merged.at(static_cast<uint16_t>((modifiers << 8) | code));
+                }
+            }
+        }
+
+        // 用作和弦修饰的按钮不再随按钮按住，映射为普通按键（例如 KEY_LEFTSHIFT）时提醒一次
+        for (size_t bit = 0; bit < kChordModifierCount; ++bit) {
+            const uint8_t code = static_cast<uint8_t>(0x80 | bit);
+            const int keyCode = table[0][code].keyCode;
+            const bool heldKey = keyCode > 0 && keyCode != MACRO_ACTION && !isRelativeMapping(keyCode);
+            if ((config.chordModifiers[presetId] & (1u << bit)) && heldKey && presetId < config.presetNames.size()) {
+                LOG_WARN("预设 %s 中 %02X 用作和弦修饰按钮，它自己的映射只在单独按下松开时点按一次，不能再按住",
+                         config.presetNames[presetId].c_str(), code);
+            }
+        }
+    }
 }
 
 // 创建默认配置文件
@@ -247,12 +784,9 @@ void ConfigManager::createDefaultConfig() {
         std::ofstream configFile(m_configPath);
         configFile << std::setw(4) << config << std::endl;
         
-        std::cout << "已创建默认配置文件: " << m_configPath << std::endl;
-        
-        // 重新加载配置
-        loadConfig();
+        LOG_INFO("已创建默认配置文件: %s", m_configPath.c_str());
     } catch (const std::exception& e) {
-        std::cerr << "创建默认配置文件失败: " << e.what() << std::endl;
+        LOG_ERROR("创建默认配置文件失败: %s", e.what());
     }
 }
 
@@ -1,42 +1,151 @@
 #ifndef CONFIG_MANAGER_HPP
 #define CONFIG_MANAGER_HPP
 
+#include <array>
+#include <chrono>
 #include <string>
 #include <map>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <fstream>
-#include <iostream>
 #include <linux/input-event-codes.h>
 #include <nlohmann/json.hpp>
 #include "uinput_helper.hpp"
+#include "acceleration.hpp"
+#include "atomic_snapshot.hpp"
+#include "macro.hpp"
+#include "pattern_matcher.hpp"
+#include "string_interner.hpp"
 
 using json = nlohmann::json;
 
-// 定义窗口规则结构
+// 定义窗口规则结构，类名和标题的条件在加载配置时编译为 DFA
 struct WindowRule {
-    std::string windowClass;
-    std::string windowTitle;
-    std::string presetName;
+    std::optional<PatternMatcher> classMatcher;  // 未设置时匹配任意类名
+    std::optional<PatternMatcher> titleMatcher;  // 未设置时匹配任意标题
+    int presetId = 0;
 
-    bool matches(const std::string& activeClass, const std::string& activeTitle) const;
+    bool matches(std::string_view activeClass, std::string_view activeTitle) const;
 };
 
-// 按键映射类型
-using KeyMapping = std::map<uint8_t, int>;
+// 一个按钮代码对应的动作
+struct ButtonAction {
+    static constexpr uint16_t kDefaultHoldMs = 10;
+    static constexpr uint16_t kNoMacro = 0xFFFF;
+
+    int keyCode = 0;                  // 0 表示无映射，MACRO_ACTION 表示宏
+    uint16_t holdMs = kDefaultHoldMs; // 按下后保持多久再释放
+    uint16_t macroId = kNoMacro;      // 宏在 CompiledConfig::macros 中的下标
+};
+
+// 和弦修饰按钮：长键 (0x80)、侧键 (0x81)、横键 (0x82)、短键 (0x83)，修饰位为按下码的低 2 位
+constexpr size_t kChordModifierCount = 4;
+constexpr size_t kChordLayerCount = size_t{1} << kChordModifierCount;
+
+// 按钮代码对应的修饰位，不是修饰按钮时返回 0
+constexpr uint8_t chordModifierBit(uint8_t code) {
+    return (code & 0xFC) == 0x80 ? static_cast<uint8_t>(1u << (code & 0x03)) : 0;
+}
+
+// 按键映射类型（解析配置文件时使用的中间表示），键为 (修饰位掩码 << 8) | 按钮代码
+using KeyMapping = std::map<uint16_t, ButtonAction>;
+
+// 一层动作表：以按钮代码为下标的 256 项
+using PresetTable = std::array<ButtonAction, 256>;
+
+// 编译后的预设：以按住的修饰按钮位掩码为下标的 16 层动作表，第 0 层是没有按住修饰按钮时的映射。
+// 每一层都以第 0 层为底，再覆盖所有修饰位是该掩码子集的和弦，已合并 "default" 预设作为后备，
+// 因此查找和弦只需一次数组下标，和弦数量不影响查找开销
+using ChordTable = std::array<PresetTable, kChordLayerCount>;
+
+// 编译后的完整配置，发布后不再修改，可以在其他线程中构建
+struct CompiledConfig {
+    std::vector<std::string> presetNames;                    // 以预设 id 为下标
+    std::vector<ChordTable> presetTables;                    // 以预设 id 为下标
+    std::vector<uint8_t> chordModifiers;                     // 以预设 id 为下标，在和弦中用作修饰的按钮位掩码
+    std::vector<AccelerationProfile> accelerationProfiles;   // 以预设 id 为下标
+    std::vector<Macro> macros;                               // 以 ButtonAction::macroId 为下标
+    std::map<std::string, int> presetIds;
+    std::map<std::string, std::vector<int>> devicePresetMaps;  // 设备路径 -> 以预设 id 为下标的替换预设 id
+    std::vector<WindowRule> windowRules;
+    std::chrono::microseconds coalesceWindow{0};
+
+    // 查找预设 id，不存在时返回 0 ("default")
+    int findPresetId(const std::string& presetName) const;
+
+    // 所有预设中用到的键码（去重，按首次出现的顺序）
+    std::vector<int> keyCodes() const;
+};
 
 class ConfigManager {
 public:
+    // "default" 预设的 id 固定为 0
+    static constexpr int kDefaultPresetId = 0;
+
     ConfigManager(const std::string& configPath = "~/.config/tourbox/config.json");
     ~ConfigManager() = default;
 
-    // 加载配置文件
+    // 加载配置文件并立即发布，文件不存在时先创建默认配置；解析失败时保留当前配置
     bool loadConfig();
 
-    // 根据窗口信息获取按键映射
-    int getKeyMapping(uint8_t buttonCode, const std::string& windowClass, const std::string& windowTitle);
+    // 解析并编译配置文件，失败返回 nullptr；不修改当前配置，可以在后台线程中调用
+    std::unique_ptr<CompiledConfig> parseConfig() const;
+
+    // 用一次原子指针交换发布新配置（只能在事件循环线程中调用）
+    void publish(std::unique_ptr<const CompiledConfig> config);
+
+    // 当前生效的配置
+    const CompiledConfig& config() const { return *m_config.load(); }
+
+    // 配置文件路径（已展开 ~）
+    const std::string& configPath() const { return m_configPath; }
+
+    // 根据窗口信息解析预设 id（在焦点变化时调用）
+    // 结果按 (类名, 标题) 的预先计算的哈希缓存，同一个窗口再次获得焦点时只需一次整数键查找和 id 比较
+    int resolvePresetId(const InternedString& windowClass, const InternedString& windowTitle);
+
+    // 查找预设 id，不存在时返回 kDefaultPresetId
+    int findPresetId(const std::string& presetName) const { return config().findPresetId(presetName); }
+
+    // 获取预设名称
+    const std::string& getPresetName(int presetId) const;
+
+    // 根据预设 id 和按住的修饰按钮位掩码获取按钮动作，presetId 必须来自当前配置的 resolvePresetId()
+    const ButtonAction& getAction(uint8_t buttonCode, int presetId, uint8_t modifiers = 0) const {
+        return m_config.load()->presetTables[presetId][modifiers][buttonCode];
+    }
+
+    // 预设中在和弦里用作修饰的按钮位掩码
+    uint8_t getChordModifiers(int presetId) const { return m_config.load()->chordModifiers[presetId]; }
+
+    // 根据预设 id 获取按键映射
+    int getKeyMapping(uint8_t buttonCode, int presetId) const {
+        return getAction(buttonCode, presetId).keyCode;
+    }
+
+    // 获取编译后的宏，macroId 必须来自当前配置的 getAction()
+    const Macro& getMacro(uint16_t macroId) const { return m_config.load()->macros[macroId]; }
+
+    // 获取编译后的预设表（没有按住修饰按钮的一层）
+    const PresetTable& getPresetTable(int presetId) const { return config().presetTables[presetId][0]; }
+
+    // 获取预设的加速曲线，未配置的预设沿用 "default" 的曲线
+    const AccelerationProfile& getAcceleration(int presetId) const {
+        return m_config.load()->accelerationProfiles[presetId];
+    }
+
+    // 鼠标移动的合并时间窗，0 表示只合并同一次读取到的字节
+    std::chrono::microseconds getCoalesceWindow() const { return config().coalesceWindow; }
+
+    // 设备的预设映射表：以窗口规则选出的预设 id 为下标，没有为该设备配置时返回空表
+    // 配置中的路径和 path 都解析符号链接后比较，因此可以用 /dev/serial/by-id 下的稳定名称配置
+    std::vector<int> getDevicePresetMap(const std::string& path) const;
 
     // 获取所有需要注册的键码
-    std::vector<int> getAllKeyCodes() const;
+    std::vector<int> getAllKeyCodes() const { return config().keyCodes(); }
 
     // 创建默认配置文件
     void createDefaultConfig();
@@ -45,11 +154,47 @@ private:
     // 加载默认按键映射
     void loadDefaultMappings();
 
+    // 解析映射的按钮代码: "81" 或和弦 "81+44"（前面的代码必须是修饰按钮），失败返回 false
+    static bool parseButtonKey(const std::string& text, uint16_t& key);
+
+    // 解析一个映射值: "KEY_A"、数字键码、{"key": "KEY_A", "hold_ms": 20}、
+    // 组合键 "KEY_LEFTCTRL+KEY_Z" 或 {"macro": [...]}；宏编译后追加到 compiled.macros
+    bool parseAction(const json& value, ButtonAction& action, CompiledConfig& compiled) const;
+
+    // 编译宏: 每一步是组合键字符串或 {"delay_ms": 100}，组合键按顺序按下、逆序释放，
+    // holdMs 为 0 时按下和释放在同一次写入中完成
+    bool parseMacro(const json& steps, uint16_t holdMs, Macro& macro) const;
+
+    // 把编译好的宏加入配置，并让动作指向它
+    static bool addMacro(Macro macro, ButtonAction& action, CompiledConfig& compiled);
+
+    // 解析一台设备的预设替换: {"preset": "left"} 替换所有预设，{"presets": {"gimp": "gimp-left"}} 替换指定的预设
+    static bool parseDevicePresets(const json& value, const CompiledConfig& compiled, std::vector<int>& presetMap);
+
+    // 解析一条窗口规则并编译其中的模式，模式无效时返回 false
+    static bool parseWindowRule(const json& value, const CompiledConfig& compiled, WindowRule& rule);
+
+    // 解析一条加速曲线: {"curve": "linear", "threshold": 5, "gain": 0.2, "max": 8}
+    bool parseAccelerationCurve(const json& value, AccelerationCurve& curve) const;
+
+    // 解析一个预设的加速配置，"knob"/"dial"/"wheel" 可以单独覆盖
+    bool parseAccelerationProfile(const json& value, AccelerationProfile& profile) const;
+
+    // 将解析出的预设编译为和弦动作表，并预先合并 "default" 预设
+    static void compilePresets(const std::vector<KeyMapping>& presets, CompiledConfig& config);
+
     std::string m_configPath;
-    std::string m_activePreset;
-    std::map<std::string, KeyMapping> m_presets;
-    std::vector<WindowRule> m_windowRules;
-    std::map<std::string, int> m_keyNameMap;
+    std::map<std::string, int> m_keyNameMap;  // 构造后不再修改，解析线程只读
+    AtomicSnapshot<CompiledConfig> m_config;
+
+    // 窗口规则匹配结果缓存，键为类名和标题的组合哈希；命中时再比较驻留 id，哈希冲突时覆盖旧项。发布新配置时清空
+    struct RuleCacheEntry {
+        uint32_t windowClassId;
+        uint32_t windowTitleId;
+        int presetId;
+    };
+    static constexpr size_t kRuleCacheCapacity = 1024;
+    std::unordered_map<uint64_t, RuleCacheEntry> m_ruleCache;
 };
 
 #endif // CONFIG_MANAGER_HPP
@@ -0,0 +1,157 @@
+#include "config_watcher.hpp"
+#include "logger.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+ConfigWatcher::ConfigWatcher(ConfigManager& configManager)
+    : m_configManager(configManager) {}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+// 开始监视
+bool ConfigWatcher::start(EventLoop& loop, ReloadCallback onReload, PrepareCallback onPrepare) {
+    const std::filesystem::path configPath(m_configManager.configPath());
+    m_fileName = configPath.filename().string();
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0) {
+        LOG_ERROR("inotify_init1 失败: %s", strerror(errno));
+        return false;
+    }
+
+    // 相对路径的文件名没有目录部分，监视当前目录
+    const std::string directory = configPath.has_parent_path() ? configPath.parent_path().string() : ".";
+    if (inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        LOG_ERROR("无法监视配置目录 %s: %s", directory.c_str(), strerror(errno));
+        stop();
+        return false;
+    }
+
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_eventFd < 0) {
+        LOG_ERROR("eventfd 失败: %s", strerror(errno));
+        stop();
+        return false;
+    }
+
+    if (!loop.addFd(m_inotifyFd, EPOLLIN, [this](uint32_t) { onInotifyReadable(); }) ||
+        !loop.addFd(m_eventFd, EPOLLIN, [this](uint32_t) { onWorkerFinished(); })) {
+        loop.removeFd(m_inotifyFd);
+        stop();
+        return false;
+    }
+
+    m_loop = &loop;
+    m_onReload = std::move(onReload);
+    m_onPrepare = std::move(onPrepare);
+    return true;
+}
+
+// 停止监视
+void ConfigWatcher::stop() {
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_workerRunning = false;
+    m_result.reset();
+
+    if (m_loop) {
+        m_loop->cancelTimer(m_debounceTimer);
+        m_debounceTimer = EventLoop::kInvalidTimer;
+        m_loop->removeFd(m_inotifyFd);
+        m_loop->removeFd(m_eventFd);
+        m_loop = nullptr;
+    }
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+    if (m_eventFd >= 0) {
+        close(m_eventFd);
+        m_eventFd = -1;
+    }
+}
+
+// inotify 可读
+void ConfigWatcher::onInotifyReadable() {
+    alignas(struct inotify_event) std::array<char, 4096> buffer;
+    bool changed = false;
+
+    while (true) {
+        ssize_t bytesRead = read(m_inotifyFd, buffer.data(), buffer.size());
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < bytesRead;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer.data() + offset);
+            if (event->len > 0 && m_fileName == event->name) {
+                changed = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    // 编辑器保存时可能连续触发多个事件，等待片刻后只解析一次
+    m_loop->cancelTimer(m_debounceTimer);
+    m_debounceTimer = m_loop->addTimer(kDebounceDelay, [this]() {
+        m_debounceTimer = EventLoop::kInvalidTimer;
+        if (m_workerRunning) {
+            m_reloadPending = true;
+        } else {
+            startWorker();
+        }
+    });
+}
+
+// 在后台线程中解析配置
+void ConfigWatcher::startWorker() {
+    m_workerRunning = true;
+    m_reloadPending = false;
+    m_worker = std::thread([this]() {
+        m_result = m_configManager.parseConfig();
+        if (m_result && m_onPrepare) {
+            m_onPrepare(*m_result);
+        }
+        const uint64_t value = 1;
+        if (write(m_eventFd, &value, sizeof(value)) < 0) {
+            LOG_ERROR("通知配置解析完成失败: %s", strerror(errno));
+        }
+    });
+}
+
+// 后台解析完成
+void ConfigWatcher::onWorkerFinished() {
+    uint64_t value;
+    while (read(m_eventFd, &value, sizeof(value)) < 0 && errno == EINTR) {
+    }
+
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_workerRunning = false;
+
+    if (m_result) {
+        m_onReload(std::move(m_result));
+    } else {
+        LOG_WARN("配置文件有误，继续使用之前的配置");
+    }
+
+    if (m_reloadPending) {
+        startWorker();
+    }
+}
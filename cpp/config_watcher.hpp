@@ -0,0 +1,67 @@
+#ifndef CONFIG_WATCHER_HPP
+#define CONFIG_WATCHER_HPP
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "config_manager.hpp"
+#include "event_loop.hpp"
+
+// 配置文件监视器
+// 通过 inotify 监视配置文件所在目录（编辑器通常先写临时文件再重命名），文件变化后稍等片刻合并连续的写入，
+// 再在后台线程中解析和编译配置，完成后通过 eventfd 通知事件循环，由回调在事件循环线程中发布新配置。
+// 解析失败时不调用回调，当前配置保持不变。
+// 可选的准备回调在后台线程中、解析成功之后调用，用于完成耗时的准备工作（例如创建新的虚拟输入设备），
+// 它与重新加载回调不会同时运行，两者可以不加锁地共享状态
+class ConfigWatcher {
+public:
+    // 新配置解析成功后在事件循环线程中调用
+    using ReloadCallback = std::function<void(std::unique_ptr<const CompiledConfig>)>;
+
+    // 新配置解析成功后在后台线程中调用
+    using PrepareCallback = std::function<void(const CompiledConfig&)>;
+
+    // 文件变化后等待多久再解析
+    static constexpr std::chrono::milliseconds kDebounceDelay{100};
+
+    explicit ConfigWatcher(ConfigManager& configManager);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // 开始监视
+    bool start(EventLoop& loop, ReloadCallback onReload, PrepareCallback onPrepare = nullptr);
+
+    // 停止监视，等待正在进行的解析结束
+    void stop();
+
+private:
+    // inotify 可读
+    void onInotifyReadable();
+
+    // 在后台线程中解析配置
+    void startWorker();
+
+    // 后台解析完成
+    void onWorkerFinished();
+
+    ConfigManager& m_configManager;
+    EventLoop* m_loop = nullptr;
+    ReloadCallback m_onReload;
+    PrepareCallback m_onPrepare;
+
+    std::string m_fileName;
+    int m_inotifyFd = -1;
+    int m_eventFd = -1;
+    EventLoop::TimerId m_debounceTimer = EventLoop::kInvalidTimer;
+
+    std::thread m_worker;
+    bool m_workerRunning = false;
+    bool m_reloadPending = false;                 // 解析期间文件又发生了变化
+    std::unique_ptr<CompiledConfig> m_result;     // 由后台线程写入，join 之后在事件循环线程中读取
+};
+
+#endif // CONFIG_WATCHER_HPP
@@ -0,0 +1,90 @@
+#include "device_session.hpp"
+#include "logger.hpp"
+#include <span>
+
+OutputChannel::OutputChannel(OutputSink sink) : writer(std::move(sink)) {}
+
+// 把释放调度器和宏播放器注册到事件循环
+void OutputChannel::attach(EventLoop& loop) {
+    if (!scheduler.attach(loop)) {
+        LOG_WARN("按键释放调度器初始化失败，按键将立即释放");
+    }
+    macros.attach(loop);
+}
+
+// 立即写出等待释放的按键和等待中的宏步骤
+void OutputChannel::releaseAll() {
+    scheduler.releaseAll();
+    macros.finishAll();
+}
+
+DeviceSession::DeviceSession(std::string path, std::unique_ptr<InputTransport> transport,
+                             const ConfigManager& configManager, const WindowMonitor& windowMonitor,
+                             OutputChannel& output)
+    : m_path(std::move(path)),
+      m_transport(std::move(transport)),
+      m_configManager(configManager),
+      m_windowMonitor(windowMonitor),
+      m_output(output),
+      m_decoder(configManager, output.writer, output.scheduler, output.macros, output.keyHolders) {}
+
+// 注册到事件循环
+bool DeviceSession::start(EventLoop& loop, std::function<void()> onClosed) {
+    applyConfig(loop);
+    if (!m_transport->start(loop, [this](const InputBatch& batch) { processBatch(batch); }, std::move(onClosed))) {
+        LOG_ERROR("无法开始读取%s %s", m_transport->name(), m_path.c_str());
+        return false;
+    }
+    LOG_DEBUG("%s %s 已开始读取", m_transport->name(), m_path.c_str());
+    return true;
+}
+
+// 配置重新加载后更新合并时间窗和设备的预设映射表
+void DeviceSession::applyConfig(EventLoop& loop) {
+    m_decoder.setCoalesceWindow(loop, m_configManager.getCoalesceWindow());
+    m_presetMap = m_configManager.getDevicePresetMap(m_path);
+}
+
+// 解码一批输入字节并写出本批次的所有事件，再按需录制
+void DeviceSession::processBatch(const InputBatch& batch) {
+    // 预设已在焦点变化时解析好，每批字节只读取一次
+    int presetId = m_windowMonitor.snapshot()->presetId;
+    if (static_cast<size_t>(presetId) < m_presetMap.size()) {
+        presetId = m_presetMap[presetId];
+    }
+    const uint64_t resolveTime = m_latencyRecorder ? monotonicNanoseconds() : 0;
+
+    for (std::span<const uint8_t> bytes : {batch.first, batch.second}) {
+        for (uint8_t buttonCode : bytes) {
+            m_decoder.decode(buttonCode, presetId, batch.timestamp);
+        }
+    }
+    m_decoder.endBatch();
+    const uint64_t decodeTime = m_latencyRecorder ? monotonicNanoseconds() : 0;
+
+    // 本次读取解码出的所有动作一起提交
+    m_output.writer.flush();
+
+    if (m_latencyRecorder) {
+        const uint64_t writeTime = monotonicNanoseconds();
+        m_latencyRecorder->record(LatencyStage::Read, batch.readTime - batch.wakeTime);
+        m_latencyRecorder->record(LatencyStage::Resolve, resolveTime - batch.readTime);
+        const uint64_t lookupTime = m_decoder.takeLookupNanoseconds();
+        m_latencyRecorder->record(LatencyStage::Lookup, lookupTime);
+        m_latencyRecorder->record(LatencyStage::Decode, decodeTime - resolveTime - lookupTime);
+        m_latencyRecorder->record(LatencyStage::Write, writeTime - decodeTime);
+        m_latencyRecorder->record(LatencyStage::Total, writeTime - batch.wakeTime);
+    }
+
+    // 事件写出之后再录制，不增加输入延迟
+    if (m_captureWriter) {
+        m_captureWriter->append(batch.timestamp, batch.first, batch.second);
+    }
+}
+
+// 输出读取和解码统计
+void DeviceSession::printStats() const {
+    LOG_INFO("设备 %s:", m_path.c_str());
+    m_transport->printStats();
+    m_decoder.stats().print();
+}
@@ -0,0 +1,95 @@
+#ifndef DEVICE_SESSION_HPP
+#define DEVICE_SESSION_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "button_decoder.hpp"
+#include "config_manager.hpp"
+#include "event_loop.hpp"
+#include "input_transport.hpp"
+#include "latency_stats.hpp"
+#include "macro.hpp"
+#include "output_sink.hpp"
+#include "release_scheduler.hpp"
+#include "serial_capture.hpp"
+#include "uinput_helper.hpp"
+#include "window_monitor.hpp"
+
+// 一个输出目标以及写到它上面的按键释放调度和宏播放
+// 多台设备可以共用一个输出（合并成一个虚拟输入设备），也可以各自独占一个
+struct OutputChannel {
+    explicit OutputChannel(OutputSink sink);
+
+    OutputChannel(const OutputChannel&) = delete;
+    OutputChannel& operator=(const OutputChannel&) = delete;
+
+    // 把释放调度器和宏播放器注册到事件循环
+    void attach(EventLoop& loop);
+
+    // 立即写出等待释放的按键和等待中的宏步骤，由调用者负责 flush
+    void releaseAll();
+
+    UinputWriter writer;
+    ReleaseScheduler scheduler{writer};
+    MacroPlayer macros{writer};
+    KeyHolderCounts keyHolders{};  // 写到这个输出的所有设备共用的按键按住计数
+};
+
+// 一台设备：输入传输层和它自己的按钮解码状态
+// 配置和窗口快照由所有设备共享；设备可以按自己的预设映射表把窗口规则选出的预设换成另一个
+class DeviceSession {
+public:
+    DeviceSession(std::string path, std::unique_ptr<InputTransport> transport,
+                  const ConfigManager& configManager, const WindowMonitor& windowMonitor, OutputChannel& output);
+
+    DeviceSession(const DeviceSession&) = delete;
+    DeviceSession& operator=(const DeviceSession&) = delete;
+
+    // 打开设备并完成初始化
+    bool open() { return m_transport->open(); }
+
+    // 注册到事件循环，设备断开或回放结束时调用 onClosed
+    bool start(EventLoop& loop, std::function<void()> onClosed);
+
+    // 从事件循环注销
+    void stop() { m_transport->stop(); }
+
+    // 配置重新加载后更新合并时间窗和设备的预设映射表
+    void applyConfig(EventLoop& loop);
+
+    // 开启延迟统计和录制，传 nullptr 关闭
+    void setLatencyRecorder(LatencyRecorder* recorder) {
+        m_latencyRecorder = recorder;
+        m_decoder.setLookupTiming(recorder != nullptr);
+    }
+    void setCaptureWriter(CaptureWriter* writer) { m_captureWriter = writer; }
+
+    // 释放所有按住的按键，由调用者负责 flush
+    void releaseAll() { m_decoder.releaseAll(); }
+
+    // 输出读取和解码统计
+    void printStats() const;
+
+    const std::string& path() const { return m_path; }
+    OutputChannel& output() { return m_output; }
+    const ButtonDecoder& decoder() const { return m_decoder; }
+
+private:
+    // 解码一批输入字节并写出本批次的所有事件，再按需录制
+    void processBatch(const InputBatch& batch);
+
+    std::string m_path;
+    std::unique_ptr<InputTransport> m_transport;
+    const ConfigManager& m_configManager;
+    const WindowMonitor& m_windowMonitor;
+    OutputChannel& m_output;
+    ButtonDecoder m_decoder;
+    std::vector<int> m_presetMap;  // 以窗口规则选出的预设 id 为下标，为空时直接使用该预设
+    LatencyRecorder* m_latencyRecorder = nullptr;
+    CaptureWriter* m_captureWriter = nullptr;
+};
+
+#endif // DEVICE_SESSION_HPP
@@ -0,0 +1,230 @@
+#include "event_loop.hpp"
+#include "logger.hpp"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <signal.h>
+#include <stdexcept>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+EventLoop::EventLoop() : m_running(false) {
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        throw std::runtime_error(std::string("epoll_create1 失败: ") + strerror(errno));
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (size_t fd = 0; fd < m_handlers.size(); ++fd) {
+        if (m_handlers[fd] && m_handlers[fd]->owned) {
+            close(static_cast<int>(fd));
+        }
+    }
+    close(m_epollFd);
+}
+
+bool EventLoop::registerFd(int fd, uint32_t events, FdCallback callback, bool owned) {
+    if (fd < 0) {
+        return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        LOG_ERROR("epoll 注册文件描述符 %d 失败: %s", fd, strerror(errno));
+        return false;
+    }
+
+    if (static_cast<size_t>(fd) >= m_handlers.size()) {
+        m_handlers.resize(static_cast<size_t>(fd) + 1);
+    }
+
+    auto handler = std::make_unique<Handler>();
+    handler->callback = std::move(callback);
+    handler->owned = owned;
+    m_handlers[static_cast<size_t>(fd)] = std::move(handler);
+    return true;
+}
+
+// 注册文件描述符
+bool EventLoop::addFd(int fd, uint32_t events, FdCallback callback) {
+    return registerFd(fd, events, std::move(callback), false);
+}
+
+// 修改已注册文件描述符关注的事件
+bool EventLoop::modifyFd(int fd, uint32_t events) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event) < 0) {
+        LOG_ERROR("epoll 修改文件描述符 %d 失败: %s", fd, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// 注销文件描述符
+void EventLoop::removeFd(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= m_handlers.size() || !m_handlers[fd]) {
+        return;
+    }
+
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+    // 回调可能正在执行（例如在回调中注销自身），延迟到本批事件处理完再销毁
+    m_retired.push_back(std::move(m_handlers[static_cast<size_t>(fd)]));
+}
+
+// 创建定时器
+EventLoop::TimerId EventLoop::addTimer(std::chrono::nanoseconds delay, TimerCallback callback,
+                                       std::chrono::nanoseconds interval) {
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0) {
+        LOG_ERROR("timerfd_create 失败: %s", strerror(errno));
+        return kInvalidTimer;
+    }
+
+    auto toTimespec = [](std::chrono::nanoseconds duration) {
+        struct timespec value;
+        value.tv_sec = static_cast<time_t>(duration.count() / 1000000000);
+        value.tv_nsec = static_cast<long>(duration.count() % 1000000000);
+        return value;
+    };
+
+    struct itimerspec spec;
+    spec.it_value = toTimespec(delay);
+    spec.it_interval = toTimespec(interval);
+
+    // 全零的 it_value 会解除定时器，至少延迟 1ns 以保证触发
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+
+    if (timerfd_settime(timerFd, 0, &spec, nullptr) < 0) {
+        LOG_ERROR("timerfd_settime 失败: %s", strerror(errno));
+        close(timerFd);
+        return kInvalidTimer;
+    }
+
+    const bool periodic = interval.count() > 0;
+    bool registered = registerFd(timerFd, EPOLLIN,
+        [this, timerFd, periodic, callback = std::move(callback)](uint32_t) {
+            uint64_t expirations;
+            if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                return;
+            }
+            if (!periodic) {
+                cancelTimer(timerFd);
+            }
+            callback();
+        }, true);
+
+    if (!registered) {
+        close(timerFd);
+        return kInvalidTimer;
+    }
+    return timerFd;
+}
+
+// 取消定时器
+void EventLoop::cancelTimer(TimerId timerId) {
+    if (timerId < 0 || static_cast<size_t>(timerId) >= m_handlers.size()) {
+        return;
+    }
+
+    const Handler* handler = m_handlers[static_cast<size_t>(timerId)].get();
+    if (!handler || !handler->owned) {
+        return;
+    }
+
+    removeFd(timerId);
+    close(timerId);
+}
+
+// 通过 signalfd 接收信号
+bool EventLoop::addSignals(std::initializer_list<int> signalNumbers, SignalCallback callback) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signalNumber : signalNumbers) {
+        sigaddset(&mask, signalNumber);
+    }
+
+    int signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) {
+        LOG_ERROR("signalfd 创建失败: %s", strerror(errno));
+        return false;
+    }
+
+    bool registered = registerFd(signalFd, EPOLLIN,
+        [signalFd, callback = std::move(callback)](uint32_t) {
+            struct signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                callback(static_cast<int>(info.ssi_signo));
+            }
+        }, true);
+
+    if (!registered) {
+        close(signalFd);
+        return false;
+    }
+    return true;
+}
+
+// 运行事件循环
+void EventLoop::run() {
+    std::array<struct epoll_event, 32> events;
+    m_running = true;
+
+    while (m_running) {
+        int count = epoll_wait(m_epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("epoll_wait 错误: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (static_cast<size_t>(fd) >= m_handlers.size()) {
+                continue;
+            }
+
+            // 同一批事件中较早的回调可能已经注销了这个文件描述符
+            Handler* handler = m_handlers[static_cast<size_t>(fd)].get();
+            if (handler) {
+                handler->callback(events[i].events);
+            }
+        }
+
+        m_retired.clear();
+    }
+}
+
+// 请求事件循环退出
+void EventLoop::stop() {
+    m_running = false;
+}
+
+// 屏蔽信号
+bool EventLoop::blockSignals(std::initializer_list<int> signalNumbers) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signalNumber : signalNumbers) {
+        sigaddset(&mask, signalNumber);
+    }
+
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) < 0) {
+        LOG_ERROR("屏蔽信号失败: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <sys/epoll.h>
+
+// 基于 epoll 的单线程事件循环
+// 串口、signalfd、timerfd 以及窗口后端的文件描述符都注册在这里，
+// 没有事件时 epoll_wait 无限期阻塞，不会产生周期性唤醒
+class EventLoop {
+public:
+    using FdCallback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using SignalCallback = std::function<void(int signalNumber)>;
+
+    // 定时器标识（即 timerfd），-1 表示无效
+    using TimerId = int;
+    static constexpr TimerId kInvalidTimer = -1;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 注册文件描述符，events 为 EPOLLIN 等标志
+    bool addFd(int fd, uint32_t events, FdCallback callback);
+
+    // 修改已注册文件描述符关注的事件
+    bool modifyFd(int fd, uint32_t events);
+
+    // 注销文件描述符（不会关闭它）
+    void removeFd(int fd);
+
+    // 创建定时器，delay 后触发；interval 非零时周期触发，否则触发一次后自动销毁
+    TimerId addTimer(std::chrono::nanoseconds delay, TimerCallback callback,
+                     std::chrono::nanoseconds interval = std::chrono::nanoseconds::zero());
+
+    // 取消定时器
+    void cancelTimer(TimerId timerId);
+
+    // 通过 signalfd 接收信号；调用前必须已在所有线程中屏蔽这些信号
+    bool addSignals(std::initializer_list<int> signalNumbers, SignalCallback callback);
+
+    // 运行事件循环直到 stop() 被调用
+    void run();
+
+    // 请求事件循环在处理完当前这批事件后退出
+    void stop();
+
+    // 在创建任何线程之前屏蔽信号，使其只能通过 signalfd 接收
+    static bool blockSignals(std::initializer_list<int> signalNumbers);
+
+private:
+    struct Handler {
+        FdCallback callback;
+        bool owned = false;  // 由事件循环创建（timerfd/signalfd），需要负责关闭
+    };
+
+    bool registerFd(int fd, uint32_t events, FdCallback callback, bool owned);
+
+    int m_epollFd;
+    bool m_running;
+    // 以文件描述符为下标；Handler 地址固定，回调中增删文件描述符是安全的
+    std::vector<std::unique_ptr<Handler>> m_handlers;
+    // 分发过程中被注销的回调，本批事件处理完后再销毁
+    std::vector<std::unique_ptr<Handler>> m_retired;
+};
+
+#endif // EVENT_LOOP_HPP
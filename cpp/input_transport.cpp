@@ -0,0 +1,404 @@
+#include "input_transport.hpp"
+#include "latency_stats.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <linux/hidraw.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+// 设备初始化命令：启用各按钮和转动的上报
+const char kInitCommand[] = "\xb5\x00\x5d\x04\x00\x05\x00\x06\x00\x07\x00\x08\x00\x09\x00\x0b\x00\x0c\x00\x0d\x00\x0e\x00\x0f\x00\x26\x00\x27\x00\x28\x00\x29\x00\x3b\x00\x3c\x00\x3d\x00\x3e\x00\x3f\x00\x40\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x47\x00\x48\x00\x49\x00\x4a\x00\x4b\x00\x4c\x00\x4d\x00\x4e\x00\x4f\x00\x50\x00\x51\x00\x52\x00\x53\x00\x54\x00\xa8\x00\xa9\x00\xaa\x00\xab\x00\xfe";
+
+// UNIX98 伪终端从端的主设备号
+bool isPseudoTerminal(const std::string& path) {
+    struct stat status;
+    if (stat(path.c_str(), &status) < 0 || !S_ISCHR(status.st_mode)) {
+        return false;
+    }
+    const unsigned int majorNumber = major(status.st_rdev);
+    return majorNumber >= 136 && majorNumber <= 143;
+}
+
+// 报告描述符中是否有 Report ID 项（有则每个报告的第一个字节是报告 ID）
+bool hasReportIds(const struct hidraw_report_descriptor& descriptor) {
+    for (uint32_t offset = 0; offset < descriptor.size;) {
+        const uint8_t prefix = descriptor.value[offset];
+        if (prefix == 0xFE) {
+            // 长项目：第二个字节是数据长度
+            if (offset + 1 >= descriptor.size) {
+                break;
+            }
+            offset += 3 + descriptor.value[offset + 1];
+            continue;
+        }
+        if ((prefix & 0xFC) == 0x84) {
+            return true;
+        }
+        const uint32_t dataSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+        offset += 1 + dataSize;
+    }
+    return false;
+}
+
+} // namespace
+
+// 解析传输层名称
+bool parseTransportKind(const std::string& text, TransportKind& kind) {
+    if (text == "auto") {
+        kind = TransportKind::Auto;
+    } else if (text == "tty") {
+        kind = TransportKind::Tty;
+    } else if (text == "pty") {
+        kind = TransportKind::Pty;
+    } else if (text == "hidraw") {
+        kind = TransportKind::Hidraw;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 创建传输层
+std::unique_ptr<InputTransport> createTransport(TransportKind kind, const std::string& path, double speed) {
+    if (kind == TransportKind::Auto) {
+        if (std::filesystem::path(path).filename().string().rfind("hidraw", 0) == 0) {
+            kind = TransportKind::Hidraw;
+        } else if (isPseudoTerminal(path)) {
+            kind = TransportKind::Pty;
+        } else {
+            kind = TransportKind::Tty;
+        }
+    }
+
+    switch (kind) {
+        case TransportKind::Tty:
+            return std::make_unique<SerialTransport>(path);
+        case TransportKind::Pty:
+            return std::make_unique<PtyTransport>(path);
+        case TransportKind::Hidraw:
+            return std::make_unique<HidrawTransport>(path);
+        case TransportKind::Replay:
+            return std::make_unique<ReplayTransport>(path, speed);
+        case TransportKind::Auto:
+            break;
+    }
+    return nullptr;
+}
+
+// 在 /sys/class 下查找 TourBox 设备
+std::vector<std::string> discoverDevices(const std::string& sysfsRoot) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> devices;
+    std::error_code error;
+
+    auto readAttribute = [](const fs::path& path) {
+        std::string value;
+        std::ifstream file(path);
+        std::getline(file, value);
+        return value;
+    };
+
+    // USB 串口：从 tty 设备向上找到带 idVendor/idProduct 的 USB 设备节点
+    for (const auto& entry : fs::directory_iterator(fs::path(sysfsRoot) / "class/tty", error)) {
+        fs::path node = fs::canonical(entry.path() / "device", error);
+        if (error) {
+            continue;
+        }
+        for (; node.has_relative_path() && node != node.parent_path(); node = node.parent_path()) {
+            if (fs::exists(node / "idVendor", error)) {
+                if (readAttribute(node / "idVendor") == kTourboxVendorId
+                    && readAttribute(node / "idProduct") == kTourboxProductId) {
+                    devices.push_back("/dev/" + entry.path().filename().string());
+                }
+                break;
+            }
+        }
+    }
+
+    // hidraw：uevent 中的 HID_ID 为 总线:厂商:产品，均为 8 位十六进制
+    const std::string hidId = std::string("0000") + kTourboxVendorId + ":0000" + kTourboxProductId;
+    for (const auto& entry : fs::directory_iterator(fs::path(sysfsRoot) / "class/hidraw", error)) {
+        std::ifstream uevent(entry.path() / "device/uevent");
+        std::string line;
+        while (std::getline(uevent, line)) {
+            if (line.rfind("HID_ID=", 0) == 0) {
+                std::string id = line.substr(line.find(':') + 1);
+                std::transform(id.begin(), id.end(), id.begin(), [](unsigned char c) { return std::tolower(c); });
+                if (id == hidId) {
+                    devices.push_back("/dev/" + entry.path().filename().string());
+                }
+                break;
+            }
+        }
+    }
+
+    std::sort(devices.begin(), devices.end());
+    return devices;
+}
+
+SerialTransport::SerialTransport(std::string path) : m_path(std::move(path)) {}
+
+SerialTransport::~SerialTransport() {
+    stop();
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+// 打开串口、配置终端参数并发送初始化命令
+bool SerialTransport::open() {
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        LOG_ERROR("无法打开%s %s: %s", name(), m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!configure()) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    if (tcflush(m_fd, TCIOFLUSH) != 0) {
+        LOG_ERROR("清空%s缓冲区失败: %s", name(), strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    // 发送初始化命令，tcdrain 等到数据从串口发出为止，代替固定的等待时间。
+    // 协议中设备不会回复初始化命令，只在按钮或转动时才发送数据，因此无法确认设备已经处理了命令，
+    // 这里只能确认命令已经发出
+    if (write(m_fd, kInitCommand, sizeof(kInitCommand) - 1) != static_cast<ssize_t>(sizeof(kInitCommand) - 1)
+        || tcdrain(m_fd) != 0) {
+        LOG_ERROR("向%s发送初始化命令失败: %s", name(), strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_reader.emplace(m_fd);
+    return true;
+}
+
+// 115200 8N1，不做任何输入输出处理
+bool SerialTransport::configure() {
+    struct termios options;
+    memset(&options, 0, sizeof(options));
+    options.c_cflag = B115200 | CS8 | CREAD;
+
+    if (tcsetattr(m_fd, TCSANOW, &options) != 0) {
+        LOG_ERROR("设置串口参数失败: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool SerialTransport::start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) {
+    m_onBatch = std::move(onBatch);
+    m_onClosed = std::move(onClosed);
+    if (!loop.addFd(m_fd, EPOLLIN, [this](uint32_t events) { onReadable(events); })) {
+        return false;
+    }
+    m_loop = &loop;
+    return true;
+}
+
+void SerialTransport::stop() {
+    if (m_loop) {
+        m_loop->removeFd(m_fd);
+        m_loop = nullptr;
+    }
+}
+
+void SerialTransport::printStats() const {
+    if (m_reader) {
+        m_reader->stats().print();
+    }
+}
+
+// 可读时读取所有可用字节并交给回调
+void SerialTransport::onReadable(uint32_t events) {
+    // 被唤醒的时间同时作为本批字节的时间戳，用于估算转动速度
+    const uint64_t wakeTime = monotonicNanoseconds();
+
+    if (m_reader->drain() < 0) {
+        LOG_ERROR("从%s读取数据时出错: %s", name(), strerror(errno));
+    }
+    if (m_reader->pending() > 0) {
+        InputBatch batch{wakeTime, monotonicNanoseconds(), wakeTime, {}, {}};
+        size_t segmentCount = 0;
+        m_reader->peek([&](std::span<const uint8_t> bytes) {
+            (segmentCount++ == 0 ? batch.first : batch.second) = bytes;
+        });
+        m_onBatch(batch);
+        m_reader->discard();
+    }
+
+    // 设备被拔出后串口会一直处于挂起状态，继续等待只会空转
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        LOG_WARN("%s已断开", name());
+        stop();
+        m_onClosed();
+    }
+}
+
+// 原始模式，不设置波特率
+bool PtyTransport::configure() {
+    struct termios options;
+    if (tcgetattr(m_fd, &options) != 0) {
+        LOG_ERROR("读取伪终端参数失败: %s", strerror(errno));
+        return false;
+    }
+    cfmakeraw(&options);
+    if (tcsetattr(m_fd, TCSANOW, &options) != 0) {
+        LOG_ERROR("设置伪终端参数失败: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+HidrawTransport::HidrawTransport(std::string path) : m_path(std::move(path)) {}
+
+HidrawTransport::~HidrawTransport() {
+    stop();
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+// 打开 hidraw 节点并读取报告描述符
+bool HidrawTransport::open() {
+    m_fd = ::open(m_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        LOG_ERROR("无法打开 hidraw 设备 %s: %s", m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct hidraw_devinfo info;
+    if (ioctl(m_fd, HIDIOCGRAWINFO, &info) == 0) {
+        LOG_INFO("hidraw 设备 %04x:%04x (总线 %u)", static_cast<unsigned>(info.vendor) & 0xFFFF,
+                 static_cast<unsigned>(info.product) & 0xFFFF, info.bustype);
+    }
+
+    int descriptorSize = 0;
+    struct hidraw_report_descriptor descriptor;
+    if (ioctl(m_fd, HIDIOCGRDESCSIZE, &descriptorSize) == 0) {
+        descriptor.size = static_cast<uint32_t>(descriptorSize);
+        if (ioctl(m_fd, HIDIOCGRDESC, &descriptor) == 0) {
+            m_numberedReports = hasReportIds(descriptor);
+        }
+    }
+    return true;
+}
+
+bool HidrawTransport::start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) {
+    m_onBatch = std::move(onBatch);
+    m_onClosed = std::move(onClosed);
+    if (!loop.addFd(m_fd, EPOLLIN, [this](uint32_t events) { onReadable(events); })) {
+        return false;
+    }
+    m_loop = &loop;
+    return true;
+}
+
+void HidrawTransport::stop() {
+    if (m_loop) {
+        m_loop->removeFd(m_fd);
+        m_loop = nullptr;
+    }
+}
+
+void HidrawTransport::printStats() const {
+    m_stats.print();
+}
+
+// 可读时读取所有排队的报告，拼接成一批交给回调
+void HidrawTransport::onReadable(uint32_t events) {
+    const uint64_t wakeTime = monotonicNanoseconds();
+    size_t size = 0;
+
+    // 每次 read 只返回一个报告，读到 EAGAIN 为止，所有报告依次读入同一个缓冲区
+    while (kCapacity - size >= kMaxReportSize) {
+        ssize_t bytesRead = read(m_fd, m_buffer.data() + size, kCapacity - size);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("从 hidraw 设备读取数据时出错: %s", strerror(errno));
+            }
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+
+        size_t length = static_cast<size_t>(bytesRead);
+        m_stats.readCalls++;
+        m_stats.bytesRead += length;
+        m_stats.maxBytesPerRead = std::max(m_stats.maxBytesPerRead, length);
+        if (m_numberedReports) {
+            // 报告 ID 不属于协议数据，把报告内容前移一个字节（报告很短，只在使用报告 ID 的设备上发生）
+            memmove(m_buffer.data() + size, m_buffer.data() + size + 1, length - 1);
+            length--;
+        }
+        size += length;
+    }
+
+    if (size > 0) {
+        const InputBatch batch{wakeTime, monotonicNanoseconds(), wakeTime,
+                               std::span<const uint8_t>(m_buffer.data(), size), {}};
+        m_onBatch(batch);
+    }
+
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        LOG_WARN("hidraw 设备已断开");
+        stop();
+        m_onClosed();
+    }
+}
+
+ReplayTransport::ReplayTransport(std::string path, double speed) : m_path(std::move(path)), m_speed(speed) {}
+
+ReplayTransport::~ReplayTransport() {
+    stop();
+}
+
+bool ReplayTransport::open() {
+    return m_file.open(m_path);
+}
+
+// 回放时使用录制时的时间戳，转动加速与录制时一致
+bool ReplayTransport::start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) {
+    m_startTime = monotonicNanoseconds();
+    return m_replayer.start(loop, m_speed,
+        [onBatch = std::move(onBatch)](const CaptureChunk& chunk) {
+            const uint64_t wakeTime = monotonicNanoseconds();
+            onBatch(InputBatch{wakeTime, wakeTime, chunk.timestamp, chunk.bytes, {}});
+        },
+        [this, onClosed = std::move(onClosed)]() {
+            LOG_INFO("回放完成，用时 %.1f ms", static_cast<double>(monotonicNanoseconds() - m_startTime) / 1e6);
+            onClosed();
+        });
+}
+
+void ReplayTransport::stop() {
+    m_replayer.stop();
+}
+
+void ReplayTransport::printStats() const {
+    LOG_INFO("回放统计: %llu 条记录, %llu 字节", static_cast<unsigned long long>(m_replayer.chunkCount()),
+             static_cast<unsigned long long>(m_replayer.byteCount()));
+}
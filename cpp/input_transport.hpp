@@ -0,0 +1,162 @@
+#ifndef INPUT_TRANSPORT_HPP
+#define INPUT_TRANSPORT_HPP
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "event_loop.hpp"
+#include "serial_capture.hpp"
+#include "serial_reader.hpp"
+
+// 一批输入字节
+// 字节引用传输层自己的缓冲区（或映射的捕获文件），只在回调期间有效；环形缓冲区中的数据可能分成两段
+struct InputBatch {
+    uint64_t wakeTime;                // 被唤醒的时间
+    uint64_t readTime;                // 读完数据的时间
+    uint64_t timestamp;               // 字节到达的时间，用于估算转动速度
+    std::span<const uint8_t> first;
+    std::span<const uint8_t> second;
+};
+
+// 输入传输层
+// 负责打开设备、完成设备初始化并在事件循环中读取数据，解码器、映射和输出不关心字节来自哪里
+class InputTransport {
+public:
+    using BatchCallback = std::function<void(const InputBatch& batch)>;
+    // 输入结束（设备断开或回放完成）时调用
+    using ClosedCallback = std::function<void()>;
+
+    virtual ~InputTransport() = default;
+
+    // 打开设备并完成初始化，失败返回 false
+    virtual bool open() = 0;
+
+    // 注册到事件循环，每读到一批数据调用一次 onBatch
+    virtual bool start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) = 0;
+
+    // 从事件循环注销
+    virtual void stop() = 0;
+
+    // 输出读取统计
+    virtual void printStats() const {}
+
+    // 用于日志的名称
+    virtual const char* name() const = 0;
+};
+
+// 传输层类型
+enum class TransportKind : uint8_t {
+    Auto,    // 根据设备路径判断
+    Tty,     // USB 串口
+    Pty,     // 伪终端（测试和基准测试）
+    Hidraw,  // 蓝牙连接时的 hidraw 节点
+    Replay,  // 捕获文件
+};
+
+// 解析 auto/tty/pty/hidraw，失败返回 false
+bool parseTransportKind(const std::string& text, TransportKind& kind);
+
+// 创建传输层；Auto 根据路径选择 tty/pty/hidraw，Replay 时 path 为捕获文件，speed 为回放倍速
+std::unique_ptr<InputTransport> createTransport(TransportKind kind, const std::string& path, double speed = 1.0);
+
+// TourBox 的 USB 串口芯片
+constexpr const char* kTourboxVendorId = "0483";
+constexpr const char* kTourboxProductId = "5750";
+
+// 在 /sys/class/tty 和 /sys/class/hidraw 中查找所有 TourBox 设备，返回排序后的 /dev 路径
+std::vector<std::string> discoverDevices(const std::string& sysfsRoot = "/sys");
+
+// USB 串口：115200 8N1，打开后发送初始化命令
+class SerialTransport : public InputTransport {
+public:
+    explicit SerialTransport(std::string path);
+    ~SerialTransport() override;
+
+    bool open() override;
+    bool start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) override;
+    void stop() override;
+    void printStats() const override;
+    const char* name() const override { return "串口"; }
+
+protected:
+    // 配置终端参数
+    virtual bool configure();
+
+    // 可读时读取所有可用字节并交给回调
+    void onReadable(uint32_t events);
+
+    std::string m_path;
+    int m_fd = -1;
+    std::optional<SerialReader> m_reader;  // 打开设备后创建
+    EventLoop* m_loop = nullptr;
+    BatchCallback m_onBatch;
+    ClosedCallback m_onClosed;
+};
+
+// 伪终端：设置为原始模式，其余与串口相同
+class PtyTransport : public SerialTransport {
+public:
+    using SerialTransport::SerialTransport;
+
+    const char* name() const override { return "伪终端"; }
+
+protected:
+    bool configure() override;
+};
+
+// hidraw 节点：每次 read 返回一个报告，报告内容与串口协议的字节相同；
+// 报告描述符中声明了报告 ID 时去掉每个报告开头的 ID 字节
+class HidrawTransport : public InputTransport {
+public:
+    static constexpr size_t kCapacity = 4096;
+    static constexpr size_t kMaxReportSize = 512;  // 剩余空间不足一个报告时留到下次唤醒再读，避免报告被截断
+
+    explicit HidrawTransport(std::string path);
+    ~HidrawTransport() override;
+
+    bool open() override;
+    bool start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) override;
+    void stop() override;
+    void printStats() const override;
+    const char* name() const override { return "hidraw"; }
+
+private:
+    // 可读时读取所有排队的报告并交给回调
+    void onReadable(uint32_t events);
+
+    std::string m_path;
+    int m_fd = -1;
+    bool m_numberedReports = false;
+    std::array<uint8_t, kCapacity> m_buffer;
+    SerialReadStats m_stats;
+    EventLoop* m_loop = nullptr;
+    BatchCallback m_onBatch;
+    ClosedCallback m_onClosed;
+};
+
+// 捕获文件：按记录的时间间隔回放，字节直接引用映射的文件
+class ReplayTransport : public InputTransport {
+public:
+    ReplayTransport(std::string path, double speed);
+    ~ReplayTransport() override;
+
+    bool open() override;
+    bool start(EventLoop& loop, BatchCallback onBatch, ClosedCallback onClosed) override;
+    void stop() override;
+    void printStats() const override;
+    const char* name() const override { return "回放"; }
+
+private:
+    std::string m_path;
+    double m_speed;
+    CaptureFile m_file;
+    CaptureReplayer m_replayer{m_file};
+    uint64_t m_startTime = 0;
+};
+
+#endif // INPUT_TRANSPORT_HPP
@@ -0,0 +1,199 @@
+#include "kde_window_backend.hpp"
+#include "logger.hpp"
+#include <cerrno>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kKwinService = "org.kde.KWin";
+constexpr const char* kScriptingPath = "/Scripting";
+constexpr const char* kScriptingInterface = "org.kde.kwin.Scripting";
+
+// D-Bus 调用超时，KWin 无响应时不至于卡住事件循环太久
+constexpr uint64_t kCallTimeoutUs = 1000000;
+
+// KWin 脚本：KWin 6 使用 windowActivated/activeWindow，KWin 5 使用 clientActivated/activeClient
+std::string makeScript(const std::string& busName) {
+    return "const service = \"" + busName + "\";\n"
+           "let current = null;\n"
+           "function report() {\n"
+           "    callDBus(service, \"" + KdeBackend::kObjectPath + "\", \"" + KdeBackend::kInterface + "\",\n"
+           "             \"ActiveWindowChanged\", current ? String(current.resourceClass) : \"\",\n"
+           "             current ? String(current.caption) : \"\");\n"
+           "}\n"
+           "function activate(window) {\n"
+           "    if (current && current.captionChanged) current.captionChanged.disconnect(report);\n"
+           "    current = window;\n"
+           "    if (current && current.captionChanged) current.captionChanged.connect(report);\n"
+           "    report();\n"
+           "}\n"
+           "(workspace.windowActivated || workspace.clientActivated).connect(activate);\n"
+           "activate(workspace.activeWindow || workspace.activeClient);\n";
+}
+
+} // namespace
+
+// 导出的方法
+const sd_bus_vtable KdeBackend::kVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("ActiveWindowChanged", "ss", "", &KdeBackend::onActiveWindowChanged, SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END,
+};
+
+KdeBackend::KdeBackend() : m_pluginName("tourbox-window-monitor-" + std::to_string(getpid())) {}
+
+KdeBackend::~KdeBackend() {
+    stop();
+}
+
+// 连接会话总线、导出方法并加载 KWin 脚本
+bool KdeBackend::start(EventLoop& loop, WindowCallback onWindow) {
+    if (m_loop) {
+        return true;
+    }
+
+    int result = sd_bus_open_user(&m_bus);
+    if (result < 0) {
+        LOG_WARN("无法连接 D-Bus 会话总线: %s，窗口感知已禁用", strerror(-result));
+        m_bus = nullptr;
+        return false;
+    }
+
+    result = sd_bus_add_object_vtable(m_bus, &m_slot, kObjectPath, kInterface, kVtable, this);
+    if (result < 0) {
+        LOG_WARN("导出 D-Bus 对象失败: %s，窗口感知已禁用", strerror(-result));
+        stop();
+        return false;
+    }
+
+    m_loop = &loop;
+    m_onWindow = std::move(onWindow);
+    if (!m_loop->addFd(sd_bus_get_fd(m_bus), EPOLLIN, [this](uint32_t events) { onReadable(events); })) {
+        m_loop = nullptr;
+        stop();
+        return false;
+    }
+
+    if (!loadScript()) {
+        LOG_WARN("无法向 KWin 加载窗口监控脚本，窗口感知已禁用");
+        stop();
+        return false;
+    }
+
+    // 脚本启动时立即报告一次当前窗口，这个调用通常在 sd_bus_call 等待 start 的回复期间到达，
+    // 已经被读入 sd-bus 的内部队列，描述符不会再变为可读，需要主动处理一次，否则要等到下一次无关的消息
+    onReadable(0);
+    if (!m_loop) {
+        return false;
+    }
+
+    LOG_INFO("已通过 KWin 脚本监控活动窗口");
+    return true;
+}
+
+// 卸载脚本并断开连接
+void KdeBackend::stop() {
+    if (m_bus && m_scriptLoaded) {
+        unloadScript();
+    }
+    if (m_loop) {
+        m_loop->removeFd(sd_bus_get_fd(m_bus));
+        m_loop = nullptr;
+    }
+    m_slot = sd_bus_slot_unref(m_slot);
+    m_bus = sd_bus_flush_close_unref(m_bus);
+}
+
+// 调用 KWin 脚本接口的一个方法
+bool KdeBackend::callScripting(const char* method, sd_bus_message** reply, const char* types, ...) {
+    sd_bus_message* request = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+
+    int result = sd_bus_message_new_method_call(m_bus, &request, kKwinService, kScriptingPath, kScriptingInterface,
+                                                method);
+    if (result >= 0) {
+        va_list arguments;
+        va_start(arguments, types);
+        result = sd_bus_message_appendv(request, types, arguments);
+        va_end(arguments);
+    }
+    if (result >= 0) {
+        result = sd_bus_call(m_bus, request, kCallTimeoutUs, &error, reply);
+    }
+    if (result < 0) {
+        LOG_WARN("调用 KWin %s 失败: %s", method, error.message ? error.message : strerror(-result));
+    }
+
+    sd_bus_error_free(&error);
+    sd_bus_message_unref(request);
+    return result >= 0;
+}
+
+// 生成脚本并交给 KWin 加载运行
+bool KdeBackend::loadScript() {
+    const char* uniqueName = nullptr;
+    if (sd_bus_get_unique_name(m_bus, &uniqueName) < 0) {
+        return false;
+    }
+
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    m_scriptPath = std::string(runtimeDir && *runtimeDir ? runtimeDir : "/tmp") + "/" + m_pluginName + ".js";
+    {
+        std::ofstream script(m_scriptPath, std::ios::trunc);
+        script << makeScript(uniqueName);
+        if (!script) {
+            LOG_WARN("无法写入 KWin 脚本 %s", m_scriptPath.c_str());
+            return false;
+        }
+    }
+
+    sd_bus_message* reply = nullptr;
+    if (!callScripting("loadScript", &reply, "ss", m_scriptPath.c_str(), m_pluginName.c_str())) {
+        unlink(m_scriptPath.c_str());
+        return false;
+    }
+    sd_bus_message_unref(reply);
+    m_scriptLoaded = true;
+
+    // start() 运行所有已加载但尚未运行的脚本
+    return callScripting("start", nullptr, "");
+}
+
+// 从 KWin 卸载脚本并删除脚本文件
+void KdeBackend::unloadScript() {
+    callScripting("unloadScript", nullptr, "s", m_pluginName.c_str());
+    unlink(m_scriptPath.c_str());
+    m_scriptLoaded = false;
+}
+
+// 处理连接上所有排队的消息
+void KdeBackend::onReadable(uint32_t /*events*/) {
+    int result;
+    while ((result = sd_bus_process(m_bus, nullptr)) > 0) {
+    }
+    if (result < 0) {
+        LOG_WARN("D-Bus 连接已断开: %s，窗口感知已禁用", strerror(-result));
+        stop();
+        return;
+    }
+    // 方法回复很短，直接写完
+    sd_bus_flush(m_bus);
+}
+
+// ActiveWindowChanged(ss) 方法
+int KdeBackend::onActiveWindowChanged(sd_bus_message* message, void* userdata, sd_bus_error* /*error*/) {
+    auto* backend = static_cast<KdeBackend*>(userdata);
+    const char* windowClass = nullptr;
+    const char* windowTitle = nullptr;
+
+    const int result = sd_bus_message_read(message, "ss", &windowClass, &windowTitle);
+    if (result < 0) {
+        return result;
+    }
+    backend->m_onWindow(windowClass, windowTitle);
+    return sd_bus_reply_method_return(message, "");
+}
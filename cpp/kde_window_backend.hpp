@@ -0,0 +1,51 @@
+#ifndef KDE_WINDOW_BACKEND_HPP
+#define KDE_WINDOW_BACKEND_HPP
+
+#include <string>
+#include <systemd/sd-bus.h>
+#include "window_backend.hpp"
+
+// KDE：向 KWin 加载一个脚本，脚本在活动窗口或其标题变化时通过 D-Bus 调用本进程导出的方法
+// Wayland 下的 KWin 不允许普通客户端查询活动窗口，只能由运行在合成器中的脚本推送
+// D-Bus 连接的描述符直接注册到事件循环，不轮询
+class KdeBackend : public WindowBackend {
+public:
+    static constexpr const char* kObjectPath = "/WindowMonitor";
+    static constexpr const char* kInterface = "org.tourbox.WindowMonitor";
+
+    KdeBackend();
+    ~KdeBackend() override;
+
+    bool start(EventLoop& loop, WindowCallback onWindow) override;
+    void stop() override;
+    const char* name() const override { return "KDE"; }
+
+private:
+    // 生成脚本并交给 KWin 加载运行
+    bool loadScript();
+
+    // 从 KWin 卸载脚本并删除脚本文件
+    void unloadScript();
+
+    // 调用 KWin 脚本接口的一个方法，失败时记录日志
+    bool callScripting(const char* method, sd_bus_message** reply, const char* types, ...);
+
+    // 处理连接上所有排队的消息
+    void onReadable(uint32_t events);
+
+    // 导出的方法表
+    static const sd_bus_vtable kVtable[];
+
+    // ActiveWindowChanged(ss) 方法
+    static int onActiveWindowChanged(sd_bus_message* message, void* userdata, sd_bus_error* error);
+
+    EventLoop* m_loop = nullptr;
+    WindowCallback m_onWindow;
+    sd_bus* m_bus = nullptr;
+    sd_bus_slot* m_slot = nullptr;
+    std::string m_pluginName;  // 按进程区分，同时运行多个驱动程序时互不影响
+    std::string m_scriptPath;
+    bool m_scriptLoaded = false;
+};
+
+#endif // KDE_WINDOW_BACKEND_HPP
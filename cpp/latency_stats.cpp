@@ -0,0 +1,59 @@
+#include "latency_stats.hpp"
+#include "logger.hpp"
+#include <cmath>
+
+// 桶中最大的值
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const size_t shift = (index - kSubBuckets) / kSubBuckets;
+    const uint64_t top = kSubBuckets + (index - kSubBuckets) % kSubBuckets;
+    return ((top + 1) << shift) - 1;
+}
+
+// 百分位数
+uint64_t LatencyHistogram::percentile(double percent) const {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const double clamped = std::clamp(percent, 0.0, 100.0);
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(m_count))));
+
+    uint64_t cumulative = 0;
+    for (size_t index = 0; index < m_buckets.size(); ++index) {
+        cumulative += m_buckets[index];
+        if (cumulative >= target) {
+            return std::min(bucketUpperBound(index), m_max);
+        }
+    }
+    return m_max;
+}
+
+void LatencyHistogram::reset() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+// 输出各阶段的 p50/p99/max
+void LatencyRecorder::print() const {
+    static const char* const kStageNames[] = {"读取", "预设", "查表", "解码", "写入", "总计"};
+
+    LOG_INFO("输入延迟统计 (微秒):");
+    for (size_t stage = 0; stage < m_histograms.size(); ++stage) {
+        const LatencyHistogram& histogram = m_histograms[stage];
+        LOG_INFO("  %s: %llu 次, p50 %.1f, p99 %.1f, max %.1f", kStageNames[stage],
+                 static_cast<unsigned long long>(histogram.count()),
+                 static_cast<double>(histogram.percentile(50)) / 1000.0,
+                 static_cast<double>(histogram.percentile(99)) / 1000.0,
+                 static_cast<double>(histogram.max()) / 1000.0);
+    }
+}
+
+void LatencyRecorder::reset() {
+    for (auto& histogram : m_histograms) {
+        histogram.reset();
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef LATENCY_STATS_HPP
+#define LATENCY_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// 当前 CLOCK_MONOTONIC 纳秒数
+inline uint64_t monotonicNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+// 固定桶的对数-线性直方图（与 HdrHistogram 的分桶方式相同）
+// 小于 16ns 的值每纳秒一个桶，之后每个 2 的幂区间再均分为 16 个桶，相对误差不超过 1/16。
+// 记录只需要几次整数运算和一次数组自增，不分配内存
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBuckets = 16;
+    static constexpr size_t kBucketCount = kSubBuckets + (64 - 4) * kSubBuckets;
+
+    void record(uint64_t nanoseconds) {
+        m_buckets[bucketIndex(nanoseconds)]++;
+        m_count++;
+        m_max = std::max(m_max, nanoseconds);
+    }
+
+    uint64_t count() const { return m_count; }
+    uint64_t max() const { return m_max; }
+
+    // 百分位数（0-100），返回所在桶的上界
+    uint64_t percentile(double percent) const;
+
+    void reset();
+
+private:
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        // 取最高 5 位：首位恒为 1，其余 4 位决定区间内的子桶
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 5;
+        return kSubBuckets + shift * kSubBuckets + static_cast<size_t>((value >> shift) - kSubBuckets);
+    }
+
+    // 桶中最大的值
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<uint64_t, kBucketCount> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
+
+// 输入处理的各个阶段
+enum class LatencyStage : uint8_t {
+    Read = 0,   // 被唤醒到读完串口数据
+    Resolve,    // 读取当前窗口对应的预设
+    Lookup,     // 在动作表中查找每个字节的映射（各次查找之和，包括计时本身的开销）
+    Decode,     // 解码字节并生成事件，不含查找映射
+    Write,      // 写入 /dev/uinput
+    Total,      // 被唤醒到写入完成
+    Count
+};
+
+// 每个阶段一个直方图，只在事件循环线程中使用
+class LatencyRecorder {
+public:
+    void record(LatencyStage stage, uint64_t nanoseconds) {
+        m_histograms[static_cast<size_t>(stage)].record(nanoseconds);
+    }
+
+    const LatencyHistogram& histogram(LatencyStage stage) const {
+        return m_histograms[static_cast<size_t>(stage)];
+    }
+
+    // 输出各阶段的 p50/p99/max
+    void print() const;
+
+    void reset();
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::Count)> m_histograms;
+};
+
+#endif // LATENCY_STATS_HPP
@@ -0,0 +1,278 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// 队列中的一条日志
+struct LogRecord {
+    std::atomic<size_t> sequence;
+    LogLevel level;
+    uint16_t length;
+    char text[Logger::kMessageCapacity];
+};
+
+// 有界多生产者队列（Vyukov），只有后台线程消费
+struct LogQueue {
+    static constexpr size_t kMask = Logger::kQueueCapacity - 1;
+    static_assert((Logger::kQueueCapacity & kMask) == 0, "队列容量必须是 2 的幂");
+
+    std::array<LogRecord, Logger::kQueueCapacity> records;
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) size_t dequeuePosition = 0;
+    alignas(64) std::atomic<uint32_t> wakeups{0};
+    std::atomic<bool> sleeping{false};      // 后台线程即将或已经在 wakeups 上等待
+    std::atomic<uint64_t> dropped{0};       // 尚未报告的丢弃条数
+    std::atomic<uint64_t> totalDropped{0};  // 累计丢弃条数
+
+    LogQueue() {
+        for (size_t i = 0; i < records.size(); ++i) {
+            records[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 取得一个可写的槽位，队列满时返回 nullptr
+    LogRecord* claim(size_t& position) {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            LogRecord& record = records[position & kMask];
+            const size_t sequence = record.sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    return &record;
+                }
+            } else if (difference < 0) {
+                return nullptr;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 发布已写好的槽位，后台线程在等待时才唤醒它，其余时候不产生系统调用
+    // 与 writerThread 中的栅栏配对：要么这里看到 sleeping，要么后台线程在等待前看到这条日志
+    void publish(LogRecord& record, size_t position) {
+        record.sequence.store(position + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            wakeups.fetch_add(1, std::memory_order_release);
+            wakeups.notify_one();
+        }
+    }
+
+    // 取出下一条日志，队列为空时返回 nullptr
+    LogRecord* peek() {
+        LogRecord& record = records[dequeuePosition & kMask];
+        if (record.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            return nullptr;
+        }
+        return &record;
+    }
+
+    // 归还 peek() 取出的槽位
+    void release(LogRecord& record) {
+        record.sequence.store(dequeuePosition + Logger::kQueueCapacity, std::memory_order_release);
+        dequeuePosition++;
+    }
+};
+
+LogQueue gQueue;
+std::thread gWriterThread;
+std::atomic<bool> gRunning{false};
+std::atomic<int> gActiveWriters{0};  // 正在向队列写入的生产者数，stop() 等它们写完再做最后一次输出
+std::atomic<bool> gStopping{false};
+std::mutex gLifecycleMutex;
+
+const char* levelPrefix(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "[跟踪] ";
+        case LogLevel::Debug: return "[调试] ";
+        case LogLevel::Warn:  return "[警告] ";
+        case LogLevel::Error: return "[错误] ";
+        default:              return "";
+    }
+}
+
+// 输出缓冲区，攒满或队列读空时一次性写出
+struct OutputBuffer {
+    int fileDescriptor;
+    std::array<char, 16384> data;
+    size_t size = 0;
+
+    void flush() {
+        size_t offset = 0;
+        while (offset < size) {
+            ssize_t written = ::write(fileDescriptor, data.data() + offset, size - offset);
+            if (written <= 0) {
+                break;
+            }
+            offset += static_cast<size_t>(written);
+        }
+        size = 0;
+    }
+
+    void append(std::string_view text) {
+        if (size + text.size() > data.size()) {
+            flush();
+        }
+        memcpy(data.data() + size, text.data(), text.size());
+        size += text.size();
+    }
+};
+
+// 把一条日志追加到对应的输出缓冲区（警告和错误输出到 stderr）
+void appendRecord(OutputBuffer& out, OutputBuffer& err, LogLevel level, std::string_view text) {
+    OutputBuffer& target = level >= LogLevel::Warn ? err : out;
+    target.append(levelPrefix(level));
+    target.append(text);
+    target.append("\n");
+}
+
+// 输出队列中所有已发布的日志，以及丢弃日志的提示
+void drainQueue(OutputBuffer& out, OutputBuffer& err) {
+    while (LogRecord* record = gQueue.peek()) {
+        appendRecord(out, err, record->level, std::string_view(record->text, record->length));
+        gQueue.release(*record);
+    }
+    out.flush();
+    err.flush();
+
+    const uint64_t dropped = gQueue.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        char notice[96];
+        int length = snprintf(notice, sizeof(notice), "[警告] 日志队列已满，丢弃了 %llu 条日志\n",
+                              static_cast<unsigned long long>(dropped));
+        err.append(std::string_view(notice, static_cast<size_t>(length)));
+        err.flush();
+    }
+}
+
+// 后台线程：批量输出队列中的日志
+void writerThread() {
+    OutputBuffer out{STDOUT_FILENO, {}, 0};
+    OutputBuffer err{STDERR_FILENO, {}, 0};
+
+    while (true) {
+        drainQueue(out, err);
+
+        if (gStopping.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        // 队列为空时阻塞等待：先声明要等待，再确认队列仍为空，之后发布的日志一定会唤醒这里
+        const uint32_t seen = gQueue.wakeups.load(std::memory_order_acquire);
+        gQueue.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!gQueue.peek() && !gStopping.load(std::memory_order_acquire)) {
+            gQueue.wakeups.wait(seen, std::memory_order_acquire);
+        }
+        gQueue.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+// 解析级别名称
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    static constexpr std::pair<std::string_view, LogLevel> kLevels[] = {
+        {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+        {"warn", LogLevel::Warn},   {"error", LogLevel::Error}, {"off", LogLevel::Off},
+    };
+    for (const auto& [levelName, value] : kLevels) {
+        if (name == levelName) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 格式化一条日志并放入队列
+void Logger::write(LogLevel level, const char* format, ...) {
+    va_list arguments;
+
+    // 后台线程未运行（启动前、退出后或工具程序中）时同步输出。
+    // 先登记再检查 gRunning，与 stop() 中先清除 gRunning 再等待 gActiveWriters 配对
+    gActiveWriters.fetch_add(1, std::memory_order_seq_cst);
+    if (!gRunning.load(std::memory_order_seq_cst)) {
+        gActiveWriters.fetch_sub(1, std::memory_order_release);
+        char text[kMessageCapacity];
+        va_start(arguments, format);
+        int length = vsnprintf(text, sizeof(text), format, arguments);
+        va_end(arguments);
+        if (length < 0) {
+            return;
+        }
+        FILE* stream = level >= LogLevel::Warn ? stderr : stdout;
+        fprintf(stream, "%s%s\n", levelPrefix(level), text);
+        fflush(stream);
+        return;
+    }
+
+    size_t position;
+    LogRecord* record = gQueue.claim(position);
+    if (!record) {
+        gQueue.dropped.fetch_add(1, std::memory_order_relaxed);
+        gQueue.totalDropped.fetch_add(1, std::memory_order_relaxed);
+        gActiveWriters.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    // 直接格式化到槽位中，超长的消息会被截断
+    va_start(arguments, format);
+    int length = vsnprintf(record->text, sizeof(record->text), format, arguments);
+    va_end(arguments);
+
+    record->level = level;
+    record->length = static_cast<uint16_t>(length < 0 ? 0 : std::min<size_t>(length, sizeof(record->text) - 1));
+    gQueue.publish(*record, position);
+    gActiveWriters.fetch_sub(1, std::memory_order_release);
+}
+
+// 启动后台输出线程
+void Logger::start() {
+    std::lock_guard<std::mutex> lock(gLifecycleMutex);
+    if (gRunning.load()) {
+        return;
+    }
+
+    gStopping.store(false);
+    gWriterThread = std::thread(writerThread);
+    gRunning.store(true, std::memory_order_release);
+}
+
+// 输出队列中剩余的日志并停止后台线程
+void Logger::stop() {
+    std::lock_guard<std::mutex> lock(gLifecycleMutex);
+    if (!gRunning.load()) {
+        return;
+    }
+
+    // 先让新日志改为同步输出，再停止后台线程
+    gRunning.store(false, std::memory_order_seq_cst);
+    gStopping.store(true, std::memory_order_seq_cst);
+    gQueue.wakeups.fetch_add(1, std::memory_order_release);
+    gQueue.wakeups.notify_one();
+    gWriterThread.join();
+
+    // 在 gRunning 清除之前开始写入的日志可能在后台线程退出后才发布，等它们写完再输出
+    while (gActiveWriters.load(std::memory_order_acquire) > 0) {
+        std::this_thread::yield();
+    }
+    OutputBuffer out{STDOUT_FILENO, {}, 0};
+    OutputBuffer err{STDERR_FILENO, {}, 0};
+    drainQueue(out, err);
+}
+
+// 因队列满而丢弃的日志条数
+uint64_t Logger::droppedCount() {
+    return gQueue.totalDropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 日志级别
+enum class LogLevel : uint8_t {
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+// 异步日志
+//
+// 调用线程只把格式化好的消息放入一个无锁的有界环形队列（多生产者），由后台线程
+// 批量写到 stdout/stderr，输入处理路径上不会发生同步的 flush。
+// 队列满时新消息被丢弃并计数，绝不阻塞调用者。
+// 低于当前级别的日志在宏里就被过滤掉，参数不会被求值，关闭时只有一次原子读取的开销。
+class Logger {
+public:
+    static constexpr size_t kQueueCapacity = 1024;  // 必须是 2 的幂
+    static constexpr size_t kMessageCapacity = 240;
+
+    // 当前级别是否输出
+    static bool enabled(LogLevel level) {
+        return static_cast<uint8_t>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+
+    static void setLevel(LogLevel level) {
+        s_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    static LogLevel level() {
+        return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed));
+    }
+
+    // 解析级别名称: trace/debug/info/warn/error/off
+    static bool parseLevel(const std::string& name, LogLevel& level);
+
+    // 格式化一条日志并放入队列；后台线程未启动时直接同步输出
+    static void write(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // 启动后台输出线程
+    static void start();
+
+    // 输出队列中剩余的日志并停止后台线程
+    static void stop();
+
+    // 因队列满而丢弃的日志条数
+    static uint64_t droppedCount();
+
+    // 在作用域内运行后台输出线程，确保任何退出路径都会把日志输出完
+    class Session {
+    public:
+        Session() { Logger::start(); }
+        ~Session() { Logger::stop(); }
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+    };
+
+private:
+    static inline std::atomic<uint8_t> s_level{static_cast<uint8_t>(LogLevel::Info)};
+};
+
+#define TOURBOX_LOG(level, ...)                  \
+    do {                                         \
+        if (Logger::enabled(level)) {            \
+            Logger::write(level, __VA_ARGS__);   \
+        }                                        \
+    } while (0)
+
+#define LOG_TRACE(...) TOURBOX_LOG(LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) TOURBOX_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  TOURBOX_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...)  TOURBOX_LOG(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) TOURBOX_LOG(LogLevel::Error, __VA_ARGS__)
+
+#endif // LOGGER_HPP
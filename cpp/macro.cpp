@@ -0,0 +1,63 @@
+#include "macro.hpp"
+#include "latency_stats.hpp"
+#include "logger.hpp"
+
+MacroPlayer::MacroPlayer(UinputWriter& writer) : m_writer(writer) {}
+
+MacroPlayer::~MacroPlayer() {
+    if (m_loop) {
+        for (auto& [key, pending] : m_pending) {
+            m_loop->cancelTimer(pending.timer);
+        }
+    }
+}
+
+void MacroPlayer::attach(EventLoop& loop) {
+    m_loop = &loop;
+}
+
+// 播放宏
+void MacroPlayer::play(const Macro& macro) {
+    const uint64_t now = monotonicNanoseconds();
+
+    for (const MacroStep& step : macro.steps) {
+        const std::span<const struct input_event> events = macro.stepEvents(step);
+        if (step.offsetMs == 0 || !m_loop) {
+            m_writer.appendEvents(events);
+            continue;
+        }
+
+        const PendingKey key(now + static_cast<uint64_t>(step.offsetMs) * 1000000ull, m_sequence++);
+        Pending& pending = m_pending[key];
+        pending.events.assign(events.begin(), events.end());
+        pending.timer = m_loop->addTimer(std::chrono::milliseconds(step.offsetMs), [this, key]() { onTimer(key); });
+        if (pending.timer == EventLoop::kInvalidTimer) {
+            // 无法创建定时器时立即写出，至少保证按键不会一直按住
+            LOG_WARN("宏定时器创建失败，剩余步骤立即执行");
+            m_writer.appendEvents(pending.events);
+            m_pending.erase(key);
+        }
+    }
+}
+
+// 定时器到期
+void MacroPlayer::onTimer(PendingKey key) {
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) {
+        return;
+    }
+    m_writer.appendEvents(it->second.events);
+    m_pending.erase(it);
+    m_writer.flush();
+}
+
+// 立即写出所有等待中的段
+void MacroPlayer::finishAll() {
+    for (auto& [key, pending] : m_pending) {
+        if (m_loop) {
+            m_loop->cancelTimer(pending.timer);
+        }
+        m_writer.appendEvents(pending.events);
+    }
+    m_pending.clear();
+}
@@ -0,0 +1,73 @@
+#ifndef MACRO_HPP
+#define MACRO_HPP
+
+#include <cstdint>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+#include <linux/input.h>
+#include "event_loop.hpp"
+#include "uinput_helper.hpp"
+
+// 宏的一段：同一时刻写出的若干事件帧
+struct MacroStep {
+    uint32_t offsetMs;  // 相对宏开始的时间
+    uint32_t begin;     // 在 Macro::events 中的起始下标
+    uint32_t count;     // 事件数（包括 SYN_REPORT）
+};
+
+// 编译后的宏：加载配置时生成好所有 input_event 帧，播放时只需整段复制
+struct Macro {
+    static constexpr size_t kMaxEvents = 1024;
+
+    std::vector<struct input_event> events;
+    std::vector<MacroStep> steps;   // 按 offsetMs 递增排列
+    std::vector<int> keyCodes;      // 用到的键码，用于注册虚拟输入设备
+
+    std::span<const struct input_event> stepEvents(const MacroStep& step) const {
+        return std::span<const struct input_event>(events.data() + step.begin, step.count);
+    }
+};
+
+// 宏播放器
+// 第一段（offsetMs 为 0）立即追加到写入器，随本批次一起提交；之后的各段复制一份后交给事件循环的定时器，
+// 到期时写出，不阻塞输入处理。复制保证了配置重新加载后等待中的段仍然有效
+class MacroPlayer {
+public:
+    explicit MacroPlayer(UinputWriter& writer);
+    ~MacroPlayer();
+
+    MacroPlayer(const MacroPlayer&) = delete;
+    MacroPlayer& operator=(const MacroPlayer&) = delete;
+
+    // 使用事件循环的定时器播放延迟的段；未调用时所有段立即写出
+    void attach(EventLoop& loop);
+
+    // 播放宏，由调用者负责 flush
+    void play(const Macro& macro);
+
+    // 立即写出所有等待中的段（重建设备或退出时调用，保证按下的按键都被释放），由调用者负责 flush
+    void finishAll();
+
+    // 等待中的段数
+    size_t pendingCount() const { return m_pending.size(); }
+
+private:
+    struct Pending {
+        std::vector<struct input_event> events;
+        EventLoop::TimerId timer = EventLoop::kInvalidTimer;
+    };
+    // 以 (到期时间, 序号) 排序，finishAll 时按到期顺序写出
+    using PendingKey = std::pair<uint64_t, uint64_t>;
+
+    // 定时器到期
+    void onTimer(PendingKey key);
+
+    UinputWriter& m_writer;
+    EventLoop* m_loop = nullptr;
+    std::map<PendingKey, Pending> m_pending;
+    uint64_t m_sequence = 0;
+};
+
+#endif // MACRO_HPP
@@ -1,311 +1,535 @@
+#include <algorithm>
 #include <array>
-#include <cstring>
+#include <chrono>
+#include <cstdlib>
 #include <fcntl.h>
-#include <iostream>
+#include <iterator>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <signal.h>
+#include <span>
 #include <stdint.h>
 #include <string>
-#include <termios.h>
 #include <unistd.h>
-#include <iomanip>
+#include <memory>
+#include <optional>
 
 // Local
 #include "uinput_helper.hpp"
 #include "config_manager.hpp"
 #include "window_monitor.hpp"
+#include "event_loop.hpp"
+#include "release_scheduler.hpp"
+#include "button_decoder.hpp"
+#include "config_watcher.hpp"
+#include "logger.hpp"
+#include "latency_stats.hpp"
+#include "serial_capture.hpp"
+#include "input_transport.hpp"
+#include "device_session.hpp"
 
 // 全局变量
-int gUinputFileDescriptor = 0;
 ConfigManager* gConfigManager = nullptr;
 WindowMonitor* gWindowMonitor = nullptr;
+LatencyRecorder* gLatencyRecorder = nullptr;  // 未开启 --latency 时为空
+std::vector<std::unique_ptr<DeviceSession>>* gDevices = nullptr;
 
-void sigint_handler(sig_atomic_t /* s */)
-{
-	std::cout << "接收到中断信号，正在清理资源..." << std::endl;
+// 启动时各阶段的耗时
+struct StartupTimings {
+	using Clock = std::chrono::steady_clock;
 
-	// 停止窗口监控
-	if (gWindowMonitor) {
-		gWindowMonitor->stop();
-		delete gWindowMonitor;
-		gWindowMonitor = nullptr;
-	}
+	Clock::time_point start = Clock::now();
+	double configMs = 0.0;
+	double uinputMs = 0.0;
+	double serialMs = 0.0;
+	double windowMonitorMs = 0.0;
 
-	// 清理配置管理器
-	if (gConfigManager) {
-		delete gConfigManager;
-		gConfigManager = nullptr;
+	static double millisecondsSince(Clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
 	}
+};
 
-	// 销毁虚拟输入设备
-	destroyUinput(gUinputFileDescriptor);
+// 在后台线程中完成的启动步骤：解析配置并创建输出目标（虚拟输入设备需要配置中的键码）
+struct CoreSetup {
+	ConfigManager* configManager = nullptr;
+	std::vector<OutputSink> sinks;  // 任何一个创建失败时为空
+	std::vector<int> keyCodes;
+};
 
-	std::cout << "资源清理完成，退出程序" << std::endl;
-	exit(0);
+// 第 index 个输出文件的路径：第一个使用原路径，之后的加上 .1、.2 等后缀
+static std::string outputPathFor(const std::string& outputPath, size_t index)
+{
+	return index == 0 ? outputPath : outputPath + "." + std::to_string(index);
 }
 
-int main(int argc, char **argv)
+static CoreSetup setupConfigAndOutput(StartupTimings& timings, const std::string& configPath,
+	SinkKind sinkKind, const std::string& outputPath, size_t outputCount)
 {
-	std::cout << "Tourbox Neo Linux 驱动程序启动" << std::endl;
-	std::cout << "支持 Hyprland 窗口感知的动态配置" << std::endl;
+	CoreSetup setup;
+
+	auto stageStart = StartupTimings::Clock::now();
+	setup.configManager = configPath.empty() ? new ConfigManager() : new ConfigManager(configPath);
+	timings.configMs = StartupTimings::millisecondsSince(stageStart);
+
+	stageStart = StartupTimings::Clock::now();
+	setup.keyCodes = setup.configManager->getAllKeyCodes();
+	for (size_t index = 0; index < outputCount; ++index) {
+		OutputSink sink{NullSink()};
+		if (!openOutputSink(sinkKind, outputPathFor(outputPath, index), setup.keyCodes, sink)) {
+			for (OutputSink& opened : setup.sinks) {
+				closeOutputSink(opened);
+			}
+			setup.sinks.clear();
+			break;
+		}
+		setup.sinks.push_back(std::move(sink));
+	}
+	timings.uinputMs = StartupTimings::millisecondsSince(stageStart);
 
-	const int num_required_params = 2;
+	return setup;
+}
 
-	if (argc != num_required_params)
-	{
-		std::cerr << "错误: 参数数量无效，期望 " << num_required_params << ", 实际接收到 " << argc << std::endl;
-		std::cerr << "用法: " << argv[0] << " <串口设备路径>" << std::endl;
-		return 1;
+int main(int argc, char **argv)
+{
+	StartupTimings timings;
+
+	// 日志级别：环境变量 TOURBOX_LOG_LEVEL，命令行 --log-level 优先
+	const char* levelFromEnv = getenv("TOURBOX_LOG_LEVEL");
+	if (levelFromEnv && *levelFromEnv) {
+		LogLevel level;
+		if (Logger::parseLevel(levelFromEnv, level)) {
+			Logger::setLevel(level);
+		} else {
+			LOG_WARN("忽略无效的 TOURBOX_LOG_LEVEL: %s", levelFromEnv);
+		}
 	}
 
-	const std::string serialPortFile = argv[1];
+	std::vector<std::string> devicePaths;
+	bool discover = false;
+	bool separateOutputs = false;
+	bool showTimings = false;
+	bool measureLatency = false;
+	std::string configPath;
+	std::string outputPath;
+	SinkKind sinkKind = SinkKind::Uinput;
+	std::string recordPath;
+	std::string replayPath;
+	double replaySpeed = 1.0;
+	TransportKind transportKind = TransportKind::Auto;
+	WindowBackendKind windowBackendKind = WindowBackendKind::Auto;
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument == "--log-level" && i + 1 < argc) {
+			LogLevel level;
+			if (!Logger::parseLevel(argv[++i], level)) {
+				LOG_ERROR("无效的日志级别 '%s'，可选 trace/debug/info/warn/error/off", argv[i]);
+				return 1;
+			}
+			Logger::setLevel(level);
+		} else if (argument == "--timings") {
+			showTimings = true;
+		} else if (argument == "--latency") {
+			measureLatency = true;
+		} else if (argument == "--config" && i + 1 < argc) {
+			configPath = argv[++i];
+		} else if (argument == "--output" && i + 1 < argc) {
+			outputPath = argv[++i];
+			sinkKind = SinkKind::File;
+		} else if (argument == "--sink" && i + 1 < argc) {
+			if (!parseSinkKind(argv[++i], sinkKind)) {
+				LOG_ERROR("无效的输出目标 '%s'，可选 uinput/null/file", argv[i]);
+				return 1;
+			}
+		} else if (argument == "--transport" && i + 1 < argc) {
+			if (!parseTransportKind(argv[++i], transportKind)) {
+				LOG_ERROR("无效的传输层 '%s'，可选 auto/tty/pty/hidraw", argv[i]);
+				return 1;
+			}
+		} else if (argument == "--window-backend" && i + 1 < argc) {
+			if (!parseWindowBackendKind(argv[++i], windowBackendKind)) {
+				LOG_ERROR("无效的窗口后端 '%s'，可选 auto/hyprland/sway/x11/kde/none", argv[i]);
+				return 1;
+			}
+		} else if (argument == "--auto") {
+			discover = true;
+		} else if (argument == "--separate-outputs") {
+			separateOutputs = true;
+		} else if (argument == "--record" && i + 1 < argc) {
+			recordPath = argv[++i];
+		} else if (argument == "--replay" && i + 1 < argc) {
+			replayPath = argv[++i];
+		} else if (argument == "--replay-speed" && i + 1 < argc) {
+			char* end = nullptr;
+			replaySpeed = strtod(argv[++i], &end);
+			if (end == argv[i] || *end != '\0' || !(replaySpeed >= 0.0)) {
+				LOG_ERROR("无效的回放速度 '%s'，应为非负数，0 表示尽快回放", argv[i]);
+				return 1;
+			}
+		} else if (argument.rfind("--", 0) != 0) {
+			devicePaths.push_back(argument);
+		} else {
+			devicePaths.clear();
+			discover = false;
+			break;
+		}
+	}
 
-	if (std::filesystem::exists(std::filesystem::path(serialPortFile)) == false)
-	{
-		std::cerr << "错误: 找不到串口设备文件 '" << serialPortFile << "'" << std::endl;
-		return 1;
+	if (discover) {
+		for (const std::string& path : discoverDevices()) {
+			if (std::find(devicePaths.begin(), devicePaths.end(), path) == devicePaths.end()) {
+				devicePaths.push_back(path);
+			}
+		}
+		if (devicePaths.empty()) {
+			LOG_ERROR("没有找到 TourBox 设备 (USB %s:%s)", kTourboxVendorId, kTourboxProductId);
+			return 1;
+		}
 	}
 
-	// 初始化配置管理器
-	try {
-		gConfigManager = new ConfigManager();
-		std::cout << "配置管理器初始化成功" << std::endl;
-	} catch (const std::exception& e) {
-		std::cerr << "配置管理器初始化失败: " << e.what() << std::endl;
+	const bool replaying = !replayPath.empty();
+	if (devicePaths.empty() == !replaying || (!recordPath.empty() && (replaying || devicePaths.size() > 1))
+		|| (sinkKind == SinkKind::File) == outputPath.empty())
+	{
+		LOG_ERROR("用法: %s [选项] {<设备路径>... | --auto | --replay <捕获文件>}", argv[0]);
+		LOG_ERROR("  --auto                        自动查找所有 TourBox，可以和设备路径一起使用");
+		LOG_ERROR("  --transport auto|tty|pty|hidraw  设备的传输层");
+		LOG_ERROR("  --separate-outputs            每台设备使用独立的虚拟输入设备");
+		LOG_ERROR("  --record <捕获文件>           同时录制串口数据，仅限单台设备");
+		LOG_ERROR("  --replay <捕获文件>           回放捕获文件，代替设备");
+		LOG_ERROR("  --replay-speed <倍速>         回放速度，0 表示尽快回放");
+		LOG_ERROR("  --sink uinput|null|file       事件的输出目标");
+		LOG_ERROR("  --output <事件输出文件>       与 --sink file 一起使用，单独使用时相当于 --sink file");
+		LOG_ERROR("  --config <配置文件>           指定配置文件");
+		LOG_ERROR("  --window-backend auto|hyprland|sway|x11|kde|none  窗口后端");
+		LOG_ERROR("  --log-level trace|debug|info|warn|error|off  日志级别");
+		LOG_ERROR("  --timings                     输出启动各阶段耗时");
+		LOG_ERROR("  --latency                     统计各阶段处理延迟");
 		return 1;
 	}
 
-	// 初始化窗口监控器
-	try {
-		gWindowMonitor = new WindowMonitor();
-		gWindowMonitor->start();
-		std::cout << "窗口监控器启动成功" << std::endl;
-	} catch (const std::exception& e) {
-		std::cerr << "窗口监控器启动失败: " << e.what() << std::endl;
-		delete gConfigManager;
+	// 在创建任何线程（包括日志线程）之前屏蔽 SIGINT/SIGTERM/SIGUSR1，统一由事件循环中的 signalfd 处理
+	if (!EventLoop::blockSignals({SIGINT, SIGTERM, SIGUSR1})) {
 		return 1;
 	}
 
-	/// ---------- ///
-	/// Setup and open a serial port ///
+	// 日志由后台线程输出，离开 main 时把剩余日志写完
+	Logger::Session logSession;
 
-	const int serialPortFileDescriptor = open(serialPortFile.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+	LOG_INFO("Tourbox Neo Linux 驱动程序启动");
+	LOG_INFO("支持 Hyprland、Sway、X11 和 KDE 窗口感知的动态配置");
 
-	if (serialPortFileDescriptor == -1)
-	{
-		std::cerr << "Error: Failed to open serial port file " << serialPortFile << std::endl;
-		return 1;
+	for (const std::string& devicePath : devicePaths) {
+		if (std::filesystem::exists(std::filesystem::path(devicePath)) == false)
+		{
+			LOG_ERROR("找不到设备文件 '%s'", devicePath.c_str());
+			return 1;
+		}
+	}
+	if (devicePaths.size() > 1) {
+		LOG_INFO("同时连接 %zu 台设备，%s", devicePaths.size(), separateOutputs ? "每台设备使用独立的虚拟输入设备" : "共用一个虚拟输入设备");
 	}
 
-	struct termios term_options;
-	memset(&term_options, 0, sizeof(struct termios));
+	// 录制文件在启动其他组件之前打开，出错时直接退出
+	CaptureWriter captureWriter;
+	if (!recordPath.empty()) {
+		if (!captureWriter.open(recordPath)) {
+			return 1;
+		}
+		LOG_INFO("输入数据将录制到 %s", recordPath.c_str());
+	}
 
-	term_options.c_cflag = B115200 | CS8 | CREAD;
+	std::vector<std::unique_ptr<InputTransport>> transports;
+	if (replaying) {
+		devicePaths.assign(1, replayPath);
+		transports.push_back(createTransport(TransportKind::Replay, replayPath, replaySpeed));
+	} else {
+		for (const std::string& devicePath : devicePaths) {
+			transports.push_back(createTransport(transportKind, devicePath));
+		}
+	}
 
-	if ((tcsetattr(serialPortFileDescriptor, TCSANOW, &term_options)) != 0)
-	{
+	// 配置解析和虚拟输入设备创建在后台线程中进行，同时在主线程中打开输入设备并连接窗口监控
+	const size_t outputCount = separateOutputs ? devicePaths.size() : 1;
+	std::future<CoreSetup> coreSetup = std::async(std::launch::async, setupConfigAndOutput, std::ref(timings),
+		std::cref(configPath), sinkKind, std::cref(outputPath), outputCount);
 
-		std::cerr << "Error: Failed to set termios settings";
-		close(serialPortFileDescriptor);
+	// 初始化事件循环
+	std::unique_ptr<EventLoop> loop;
+	try {
+		loop = std::make_unique<EventLoop>();
+	} catch (const std::exception& e) {
+		LOG_ERROR("事件循环初始化失败: %s", e.what());
 		return 1;
 	}
 
-	if ((tcflush(serialPortFileDescriptor, TCIOFLUSH)) != 0)
-	{
+	// 初始化窗口监控器，预设解析函数等配置加载完成后再设置
+	auto stageStart = StartupTimings::Clock::now();
+	try {
+		gWindowMonitor = new WindowMonitor(createWindowBackend(windowBackendKind));
+		gWindowMonitor->start(*loop);
+		LOG_INFO("窗口监控器启动成功");
+	} catch (const std::exception& e) {
+		LOG_ERROR("窗口监控器启动失败: %s", e.what());
+		return 1;
+	}
+	timings.windowMonitorMs = StartupTimings::millisecondsSince(stageStart);
 
-		std::cerr << "Error: Failed to flush termios settings";
-		close(serialPortFileDescriptor);
+	// 打开输入设备并完成初始化（串口会发送初始化命令）
+	stageStart = StartupTimings::Clock::now();
+	bool inputOpened = true;
+	for (auto& transport : transports) {
+		inputOpened = inputOpened && transport->open();
+	}
+	timings.serialMs = StartupTimings::millisecondsSince(stageStart);
+
+	// 等待后台线程完成配置加载和虚拟输入设备创建
+	CoreSetup setup;
+	try {
+		setup = coreSetup.get();
+		gConfigManager = setup.configManager;
+		LOG_INFO("配置管理器初始化成功");
+	} catch (const std::exception& e) {
+		LOG_ERROR("配置管理器初始化失败: %s", e.what());
+		delete gWindowMonitor;
 		return 1;
 	}
 
-	// Wait for the serial port to open -- this might not be needed
-	usleep(100000);
+	if (!inputOpened) {
+		for (OutputSink& sink : setup.sinks) {
+			closeOutputSink(sink);
+		}
+		delete gWindowMonitor;
+		delete gConfigManager;
+		return 1;
+	}
 
-	std::array<uint8_t, 1> readBuffer;
+	// 窗口规则只在焦点变化时解析一次；重新加载配置后预设 id 可能重新编号，由重新加载回调重置 activePresetId
+	int activePresetId = ConfigManager::kDefaultPresetId;
+	gWindowMonitor->setPresetResolver([&activePresetId](const InternedString& windowClass, const InternedString& windowTitle) {
+		int presetId = gConfigManager->resolvePresetId(windowClass, windowTitle);
+		if (presetId != activePresetId) {
+			activePresetId = presetId;
+			LOG_INFO("切换到预设: %s", gConfigManager->getPresetName(presetId).c_str());
+			// 新预设中按钮可能映射到别的按键，切换前松开所有按住的按键
+			for (size_t index = 0; gDevices && index < gDevices->size(); ++index) {
+				DeviceSession& device = *(*gDevices)[index];
+				if (device.decoder().heldCount() > 0) {
+					device.releaseAll();
+					device.output().writer.flush();
+				}
+			}
+		}
+		return presetId;
+	});
+	// 窗口监控器可能已经收到了初始窗口，用配置重新解析一次
+	gWindowMonitor->refreshPreset();
 
 	/// ---------- ///
 	/// 设置虚拟输入设备
 
-	// 获取所有需要注册的键码
-	std::vector<int> allKeyCodes = gConfigManager->getAllKeyCodes();
-
-	// 设置虚拟输入设备
-	gUinputFileDescriptor = setupUinput(allKeyCodes);
-	if (gUinputFileDescriptor < 0) {
-		std::cerr << "设置虚拟输入设备失败" << std::endl;
+	std::vector<int>& allKeyCodes = setup.keyCodes;
+	if (setup.sinks.empty()) {
+		LOG_ERROR(sinkKind == SinkKind::File ? "打开事件输出文件失败" : "设置虚拟输入设备失败");
 		delete gWindowMonitor;
 		delete gConfigManager;
 		return 1;
 	}
 
-	std::cout << "虚拟输入设备设置成功" << std::endl;
-
-	// 注册信号处理器，确保在程序终止时清理资源
-	signal(SIGINT, sigint_handler);
-	signal(SIGTERM, sigint_handler);
+	LOG_INFO(sinkKind == SinkKind::Uinput ? "虚拟输入设备设置成功" : "输出目标创建成功");
 
-	// 等待虚拟设备初始化
-	sleep(1);
+	// 每个输出目标的事件按帧缓存，每批输入只写一次；按键释放和宏的延迟步骤由事件循环中的定时器写出
+	std::vector<std::unique_ptr<OutputChannel>> outputs;
+	for (OutputSink& sink : setup.sinks) {
+		outputs.push_back(std::make_unique<OutputChannel>(std::move(sink)));
+		outputs.back()->attach(*loop);
+	}
 
-	std::cout << "Tourbox Neo 驱动程序准备就绪，按 Ctrl+C 退出" << std::endl;
+	// 每台设备有自己的按钮状态机，按住的按钮会一直按住映射的按键；配置和窗口快照由所有设备共享
+	std::vector<std::unique_ptr<DeviceSession>> devices;
+	for (size_t index = 0; index < transports.size(); ++index) {
+		OutputChannel& output = *outputs[separateOutputs ? index : 0];
+		devices.push_back(std::make_unique<DeviceSession>(devicePaths[index], std::move(transports[index]),
+			*gConfigManager, *gWindowMonitor, output));
+	}
+	gDevices = &devices;
+	if (!recordPath.empty()) {
+		devices.front()->setCaptureWriter(&captureWriter);
+	}
 
-	write(serialPortFileDescriptor, "\xb5\x00\x5d\x04\x00\x05\x00\x06\x00\x07\x00\x08\x00\x09\x00\x0b\x00\x0c\x00\x0d\x00\x0e\x00\x0f\x00\x26\x00\x27\x00\x28\x00\x29\x00\x3b\x00\x3c\x00\x3d\x00\x3e\x00\x3f\x00\x40\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x47\x00\x48\x00\x49\x00\x4a\x00\x4b\x00\x4c\x00\x4d\x00\x4e\x00\x4f\x00\x50\x00\x51\x00\x52\x00\x53\x00\x54\x00\xa8\x00\xa9\x00\xaa\x00\xab\x00\xfe", 94);
+	// 监视配置文件，修改后在后台解析，成功后原子地替换当前配置
+	std::vector<int> registeredKeyCodes = allKeyCodes;
+	std::sort(registeredKeyCodes.begin(), registeredKeyCodes.end());
+
+	// 新配置出现了当前设备没有注册的键码时，在后台线程中为每个输出创建新的虚拟输入设备（包括等待就绪），
+	// 全部创建成功后才在事件循环线程中替换，否则关闭已创建的设备，继续使用原来的设备
+	const bool usesUinput = std::holds_alternative<UinputSink>(outputs.front()->writer.sink());
+	bool rebuildRequired = false;
+	std::vector<int> rebuiltKeyCodes;
+	std::vector<int> rebuiltDevices;
+
+	ConfigWatcher configWatcher(*gConfigManager);
+	auto prepareOutputs = [&](const CompiledConfig& next) {
+		std::vector<int> keyCodes = next.keyCodes();
+		std::sort(keyCodes.begin(), keyCodes.end());
+		rebuildRequired = usesUinput
+			&& !std::includes(registeredKeyCodes.begin(), registeredKeyCodes.end(), keyCodes.begin(), keyCodes.end());
+		if (!rebuildRequired) {
+			return;
+		}
 
-	while (true)
-	{
-		// 使用 select 来实现超时
-		fd_set readfds;
-		struct timeval timeout;
-		
-		// 设置超时为 100 毫秒
-		timeout.tv_sec = 0;
-		timeout.tv_usec = 100000;
-		
-		FD_ZERO(&readfds);
-		FD_SET(serialPortFileDescriptor, &readfds);
-		
-		int selectResult = select(serialPortFileDescriptor + 1, &readfds, NULL, NULL, &timeout);
-		
-		if (selectResult == -1) {
-			// 检查是否是因为信号中断
-			if (errno == EINTR) {
-				continue; // 被信号中断，重新循环
+		rebuiltKeyCodes.clear();
+		std::set_union(registeredKeyCodes.begin(), registeredKeyCodes.end(),
+			keyCodes.begin(), keyCodes.end(), std::back_inserter(rebuiltKeyCodes));
+		for (size_t index = 0; index < outputs.size(); ++index) {
+			const int fileDescriptor = setupUinput(rebuiltKeyCodes);
+			if (fileDescriptor < 0) {
+				for (int created : rebuiltDevices) {
+					destroyUinput(created);
+				}
+				rebuiltDevices.clear();
+				return;
 			}
-			std::cerr << "select() 错误: " << strerror(errno) << std::endl;
-			continue;
+			rebuiltDevices.push_back(fileDescriptor);
+		}
+	};
+
+	bool watching = configWatcher.start(*loop, [&](std::unique_ptr<const CompiledConfig> next) {
+		// 新配置中按钮可能映射到别的按键，预设也可能重新编号：先在当前设备上松开所有按住的按键
+		for (auto& device : devices) {
+			device->releaseAll();
 		}
-		
-		if (selectResult == 0) {
-			// 超时，没有数据可读
-			continue;
+		for (auto& output : outputs) {
+			output->releaseAll();
+			output->writer.flush();
 		}
-		
-		// 有数据可读
-		ssize_t bytesRead = read(serialPortFileDescriptor, readBuffer.begin(), 1);
 
-		if (bytesRead < 0)
-		{
-			if (errno == EAGAIN || errno == EWOULDBLOCK) {
-				// 非阻塞模式下暂时没有数据
-				continue;
-			}
-			std::cerr << "从串口读取数据时出错: " << strerror(errno) << std::endl;
-			continue; // 尝试继续运行而不是退出
+		gConfigManager->publish(std::move(next));
+		for (auto& device : devices) {
+			device->applyConfig(*loop);
 		}
 
-		if (bytesRead > 0)
-		{
-			// 获取当前窗口信息
-			WindowInfo currentWindow = gWindowMonitor->getCurrentWindow();
-
-			// 调试输出
-			std::cout << std::hex << std::uppercase << std::setfill('0') << std::setw(2) 
-				<< static_cast<int>(readBuffer[0]) << ": ";
-
-			// 获取按键映射并生成事件
-			int keyCode = gConfigManager->getKeyMapping(readBuffer[0], 
-											   currentWindow.windowClass, 
-											   currentWindow.windowTitle);
-
-			// 如果没有映射，跳过
-			if (keyCode == 0) {
-				std::cout << "未映射的按钮代码: 0x" << std::hex << std::setfill('0') 
-					<< std::setw(2) << static_cast<int>(readBuffer[0]) << std::endl;
-				continue;
+		if (!rebuiltDevices.empty()) {
+			for (size_t index = 0; index < outputs.size(); ++index) {
+				UinputSink previous = std::get<UinputSink>(outputs[index]->writer.sink());
+				outputs[index]->writer.setSink(UinputSink(rebuiltDevices[index]));
+				previous.close();
 			}
+			rebuiltDevices.clear();
+			registeredKeyCodes = std::move(rebuiltKeyCodes);
+			LOG_INFO("已为新增的键码重建虚拟输入设备");
+		} else if (rebuildRequired) {
+			LOG_ERROR("重建虚拟输入设备失败，新增的键码暂时无法使用");
+		}
 
-			// 根据按钮代码输出按钮名称
-			switch (readBuffer[0])
-			{
-				case 0x80:
-					std::cout << "长键按下" << std::endl;
-					break;
-				case 0x81:
-					std::cout << "侧键按下" << std::endl;
-					break;
-				case 0x82:
-					std::cout << "横键按下" << std::endl;
-					break;
-				case 0x83:
-					std::cout << "短键按下" << std::endl;
-					break;
-				case 0x4F:
-					std::cout << "转盘顺时针" << std::endl;
-					break;
-				case 0x0F:
-					std::cout << "转盘逆时针" << std::endl;
-					break;
-				case 0x90:
-					std::cout << "D-Pad 上按下" << std::endl;
-					break;
-				case 0x91:
-					std::cout << "D-Pad 下按下" << std::endl;
-					break;
-				case 0x92:
-					std::cout << "D-Pad 左按下" << std::endl;
-					break;
-				case 0x93:
-					std::cout << "D-Pad 右按下" << std::endl;
-					break;
-				case 0x8A:
-					std::cout << "滚轮单击" << std::endl;
-					break;
-				case 0x49:
-					std::cout << "滚轮上滚动" << std::endl;
-					break;
-				case 0x09:
-					std::cout << "滚轮下滚动" << std::endl;
-					break;
-				case 0xAA:
-					std::cout << "Tour 按钮按下" << std::endl;
-					break;
-				case 0xA2:
-					std::cout << "C1 按钮按下" << std::endl;
-					break;
-				case 0xA3:
-					std::cout << "C2 按钮按下" << std::endl;
-					break;
-				case 0x44:
-					std::cout << "旋钮顺时针" << std::endl;
-					break;
-				case 0x04:
-					std::cout << "旋钮逆时针" << std::endl;
-					break;
-				case 0xB7:
-					std::cout << "旋钮单击" << std::endl;
-					break;
-				case 0xB8:
-					std::cout << "转盘单击" << std::endl;
-					break;
-				default:
-					std::cout << "未知按钮: 0x" << std::hex << std::setfill('0') 
-						<< std::setw(2) << static_cast<int>(readBuffer[0]) << std::endl;
-					break;
-			}
+		// 预设 id 可能已经变化，用当前窗口重新解析，并重新输出当前预设
+		activePresetId = -1;
+		gWindowMonitor->refreshPreset();
 
-			// 生成按键事件
-			generateKeyPressEvent(gUinputFileDescriptor, keyCode);
+		LOG_INFO("配置已重新加载");
+	}, prepareOutputs);
+	if (!watching) {
+		LOG_WARN("无法监视配置文件，修改配置后需要重启驱动程序");
+	}
 
-			usleep(1000);
+	// 延迟统计：SIGUSR1 随时输出一次，退出时再输出一次
+	LatencyRecorder latencyRecorder;
+	if (measureLatency) {
+		gLatencyRecorder = &latencyRecorder;
+		for (auto& device : devices) {
+			device->setLatencyRecorder(&latencyRecorder);
 		}
+		LOG_INFO("已开启延迟统计，发送 SIGUSR1 (kill -USR1 %d) 输出统计", getpid());
+	}
+	loop->addSignals({SIGUSR1}, [](int) {
+		if (gLatencyRecorder) {
+			gLatencyRecorder->print();
+		} else {
+			LOG_INFO("未开启延迟统计，请使用 --latency 参数启动");
+		}
+	});
+
+	// 通过 signalfd 处理终止信号，退出事件循环后统一清理资源
+	loop->addSignals({SIGINT, SIGTERM}, [&loop](int) {
+		LOG_INFO("接收到中断信号，正在清理资源...");
+		loop->stop();
+	});
 
-		usleep(1000);
+	LOG_INFO("Tourbox Neo 驱动程序准备就绪，按 Ctrl+C 退出");
+
+	if (showTimings) {
+		LOG_INFO("启动耗时: 配置加载 %.1f ms, 虚拟输入设备 %.1f ms (与以下步骤并行), 窗口监控 %.1f ms, 串口 %.1f ms, 总计 %.1f ms",
+			timings.configMs, timings.uinputMs, timings.windowMonitorMs, timings.serialMs,
+			StartupTimings::millisecondsSince(timings.start));
 	}
 
-	usleep(1000);
+	// 每读到一批字节就解码并写出；所有设备都断开或回放结束时退出
+	size_t activeDevices = 0;
+	for (auto& device : devices) {
+		const bool started = device->start(*loop, [&activeDevices, &loop]() {
+			if (--activeDevices == 0) {
+				loop->stop();
+			}
+		});
+		if (started) {
+			++activeDevices;
+		}
+	}
+	if (activeDevices > 0) {
+		loop->run();
+	}
+	for (auto& device : devices) {
+		device->stop();
+	}
+
+	// 等待可能正在进行的配置解析结束，关闭已经创建但还没有换上的虚拟输入设备
+	configWatcher.stop();
+	for (int fileDescriptor : rebuiltDevices) {
+		destroyUinput(fileDescriptor);
+	}
+
+	// 清理资源，先释放所有仍处于按下状态的按键
+	for (auto& device : devices) {
+		device->releaseAll();
+	}
+	for (auto& output : outputs) {
+		output->releaseAll();
+		output->writer.flush();
+	}
+	gDevices = nullptr;
 
-	// 清理资源
 	if (gWindowMonitor) {
 		gWindowMonitor->stop();
 		delete gWindowMonitor;
 	}
 
+	for (auto& output : outputs) {
+		closeOutputSink(output->writer.sink());
+	}
+	for (auto& device : devices) {
+		device->printStats();
+	}
+	for (size_t index = 0; index < outputs.size(); ++index) {
+		if (outputs.size() > 1) {
+			LOG_INFO("输出 %zu:", index);
+		}
+		outputs[index]->writer.stats().print();
+	}
+	if (gLatencyRecorder) {
+		gLatencyRecorder->print();
+		gLatencyRecorder = nullptr;
+	}
+	if (!recordPath.empty()) {
+		LOG_INFO("已录制 %llu 条记录到 %s", static_cast<unsigned long long>(captureWriter.recordCount()), recordPath.c_str());
+	}
+	devices.clear();
+
 	if (gConfigManager) {
 		delete gConfigManager;
 	}
 
-	destroyUinput(gUinputFileDescriptor);
-	close(serialPortFileDescriptor);
+	LOG_INFO("资源清理完成，退出程序");
 
 	return 0;
 }
@@ -0,0 +1,266 @@
+// 按键映射查找的微基准测试
+// 对比原先基于 std::map<std::string, std::map<uint8_t,int>> 的查找路径与编译后的 256 项动作表，
+// 并测量完整的解码和映射路径（事件交给 NullSink，不产生系统调用）的吞吐量，
+// 以及窗口规则模式编译为 DFA 后与 std::regex 的匹配开销。
+// 焦点切换路径是否分配内存由 tests/window_monitor_alloc_test 检查
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <regex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "button_decoder.hpp"
+#include "config_manager.hpp"
+#include "logger.hpp"
+#include "pattern_matcher.hpp"
+#include "release_scheduler.hpp"
+#include "uinput_helper.hpp"
+#include "window_monitor.hpp"
+
+namespace {
+
+constexpr size_t kLookups = 20'000'000;
+constexpr size_t kDecodes = 2'000'000;
+constexpr size_t kBatchSize = 16;  // 每批字节数，与一次串口读取相当
+constexpr size_t kRuleMatches = 200'000;
+
+// 窗口规则中典型的正则模式和待匹配的窗口标题
+const std::vector<std::string> kRulePatterns = {
+    "^org\\.kde\\..*", "\\.blend$", "(gimp|krita|inkscape)", "^Untitled - [A-Z]\\w+$",
+};
+const std::vector<std::string> kWindowTitles = {
+    "org.kde.dolphin", "scene_final_v3.blend", "Untitled - Krita", "GNU Image Manipulation Program - gimp",
+    "Mozilla Firefox - 一个很长的网页标题，包含各种内容", "Terminal", "org.kde.konsole", "~/projects/model.blend1",
+};
+// 焦点切换时与上面的标题配对的窗口类名，默认配置中 Gimp 和 Blender 有对应的规则
+const std::vector<std::string> kWindowClasses = {
+    "org.kde.dolphin", "Blender", "krita", "Gimp", "firefox", "kitty", "org.kde.konsole", "Blender",
+};
+
+// 原先的查找路径：按预设名称查找 map，未命中时回退到 "default" 再查一次
+struct LegacyMapping {
+    std::map<std::string, std::map<uint8_t, int>> presets;
+
+    int lookup(uint8_t buttonCode, const std::string& presetName) {
+        if (presets.find(presetName) != presets.end()) {
+            const auto& mapping = presets[presetName];
+            if (mapping.find(buttonCode) != mapping.end()) {
+                return mapping.at(buttonCode);
+            }
+        }
+        if (presetName != "default" && presets.find("default") != presets.end()) {
+            const auto& defaultMapping = presets["default"];
+            if (defaultMapping.find(buttonCode) != defaultMapping.end()) {
+                return defaultMapping.at(buttonCode);
+            }
+        }
+        return 0;
+    }
+};
+
+// 由基准测试直接推送窗口变化的后端，代替合成器
+class ScriptedWindowBackend : public WindowBackend {
+public:
+    bool start(EventLoop&, WindowCallback onWindow) override {
+        m_onWindow = std::move(onWindow);
+        return true;
+    }
+    void stop() override {}
+    const char* name() const override { return "scripted"; }
+
+    void focus(std::string_view windowClass, std::string_view windowTitle) { m_onWindow(windowClass, windowTitle); }
+
+private:
+    WindowCallback m_onWindow;
+};
+
+// 从配置文件构建原先的数据结构（键码取值不影响查找开销）
+LegacyMapping loadLegacyMapping(const std::string& configPath) {
+    LegacyMapping legacy;
+    std::ifstream configFile(configPath);
+    json config;
+    configFile >> config;
+
+    int value = 1;
+    for (auto& [presetName, mappings] : config["presets"].items()) {
+        auto& preset = legacy.presets[presetName];
+        for (auto& [buttonCode, keyCode] : mappings.items()) {
+            preset[static_cast<uint8_t>(std::stoi(buttonCode, nullptr, 16))] = value++;
+        }
+    }
+    return legacy;
+}
+
+template <typename Function>
+double measureNanosecondsPerLookup(Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / kLookups;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // 默认使用临时目录中自动生成的默认配置，也可以指定真实配置文件
+    std::string configPath;
+    std::filesystem::path tempDirectory;
+    if (argc > 1) {
+        configPath = argv[1];
+    } else {
+        tempDirectory = std::filesystem::temp_directory_path() / ("tourbox_mapping_bench_" + std::to_string(getpid()));
+        configPath = (tempDirectory / "config.json").string();
+    }
+
+    ConfigManager configManager(configPath);
+    LegacyMapping legacy = loadLegacyMapping(configPath);
+
+    // 预设名称与 id 一一对应
+    std::vector<std::string> presetNames;
+    for (const auto& [presetName, mapping] : legacy.presets) {
+        presetNames.push_back(presetName);
+    }
+    std::vector<int> presetIds;
+    for (const auto& presetName : presetNames) {
+        presetIds.push_back(configManager.findPresetId(presetName));
+    }
+
+    // 生成随机的按钮代码序列，包含已映射和未映射的代码，预设偶尔切换
+    std::mt19937 random(42);
+    const std::vector<uint8_t> buttonCodes = {
+        0x80, 0x81, 0x82, 0x83, 0x4F, 0x0F, 0x90, 0x91, 0x92, 0x93,
+        0x8A, 0x49, 0x09, 0xA2, 0xA3, 0x44, 0x04, 0xB7, 0xB8, 0xAA,
+        0x00, 0x01, 0x02, 0x03, 0x10, 0x11
+    };
+    std::vector<uint8_t> codeSequence(4096);
+    std::vector<size_t> presetSequence(4096);
+    for (size_t i = 0; i < codeSequence.size(); ++i) {
+        codeSequence[i] = buttonCodes[random() % buttonCodes.size()];
+        presetSequence[i] = (i / 512) % presetNames.size();
+    }
+
+    uint64_t legacyChecksum = 0;
+    double legacyNs = measureNanosecondsPerLookup([&]() {
+        for (size_t i = 0; i < kLookups; ++i) {
+            const size_t index = i & 4095;
+            legacyChecksum += legacy.lookup(codeSequence[index], presetNames[presetSequence[index]]);
+        }
+    });
+
+    uint64_t tableChecksum = 0;
+    double tableNs = measureNanosecondsPerLookup([&]() {
+        for (size_t i = 0; i < kLookups; ++i) {
+            const size_t index = i & 4095;
+            tableChecksum += static_cast<uint64_t>(
+                configManager.getKeyMapping(codeSequence[index], presetIds[presetSequence[index]]));
+        }
+    });
+
+    // 完整路径：解码、查表、生成事件帧并按批提交给 NullSink
+    UinputWriter writer(OutputSink{NullSink()});
+    ReleaseScheduler scheduler(writer);  // 不接入事件循环，按键立即释放
+    MacroPlayer macros(writer);          // 同样不接入事件循环，宏的所有步骤立即写出
+    KeyHolderCounts keyHolders{};
+    ButtonDecoder decoder(configManager, writer, scheduler, macros, keyHolders);
+    const auto decodeStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kDecodes; ++i) {
+        const size_t index = i & 4095;
+        decoder.decode(codeSequence[index], presetIds[presetSequence[index]], static_cast<uint64_t>(i) * 1000000);
+        if ((i + 1) % kBatchSize == 0) {
+            decoder.endBatch();
+            writer.flush();
+        }
+    }
+    decoder.releaseAll();
+    decoder.endBatch();
+    writer.flush();
+    const double decodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - decodeStart).count() / kDecodes;
+
+    // 窗口规则：每个标题依次尝试所有模式，与 resolvePresetId 未命中缓存时的路径相同
+    std::vector<PatternMatcher> matchers(kRulePatterns.size());
+    std::vector<std::regex> regexes;
+    for (size_t index = 0; index < kRulePatterns.size(); ++index) {
+        std::string error;
+        if (!PatternMatcher::compileRegex(kRulePatterns[index], true, matchers[index], error)) {
+            std::cerr << "编译模式失败: " << kRulePatterns[index] << ": " << error << std::endl;
+            return 1;
+        }
+        regexes.emplace_back(kRulePatterns[index], std::regex::ECMAScript | std::regex::icase);
+    }
+
+    auto measureRules = [&](auto&& matchOne) {
+        size_t matched = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < kRuleMatches; ++i) {
+            const std::string& title = kWindowTitles[i % kWindowTitles.size()];
+            for (size_t index = 0; index < kRulePatterns.size(); ++index) {
+                if (matchOne(index, title)) {
+                    ++matched;
+                    break;
+                }
+            }
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return std::make_pair(ns / kRuleMatches, matched);
+    };
+    const auto [dfaRuleNs, dfaMatched] = measureRules([&](size_t index, const std::string& title) {
+        return matchers[index].matches(title);
+    });
+    const auto [regexRuleNs, regexMatched] = measureRules([&](size_t index, const std::string& title) {
+        return std::regex_search(title, regexes[index]);
+    });
+
+    // 完整的焦点切换路径：后端推送的类名和标题经过驻留、比较、规则缓存和快照发布。
+    // 同一组窗口轮流获得焦点，预热一轮后规则缓存命中、快照对象循环使用
+    ScriptedWindowBackend* focusBackend = nullptr;
+    auto backend = std::make_unique<ScriptedWindowBackend>();
+    focusBackend = backend.get();
+    WindowMonitor windowMonitor(std::move(backend));
+    windowMonitor.setPresetResolver([&](const InternedString& windowClass, const InternedString& windowTitle) {
+        return configManager.resolvePresetId(windowClass, windowTitle);
+    });
+    EventLoop loop;
+    windowMonitor.start(loop);
+
+    const LogLevel logLevel = Logger::level();
+    Logger::setLevel(LogLevel::Warn);  // 不输出每次窗口切换
+    auto focusRound = [&](size_t rounds) {
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < rounds; ++i) {
+            focusBackend->focus(kWindowClasses[i % kWindowClasses.size()], kWindowTitles[i % kWindowTitles.size()]);
+            checksum += static_cast<uint64_t>(windowMonitor.snapshot()->presetId);
+        }
+        return checksum;
+    };
+    focusRound(kWindowTitles.size() * AtomicSnapshot<WindowSnapshot>::kRetiredCapacity);
+
+    const auto focusStart = std::chrono::steady_clock::now();
+    const uint64_t focusChecksum = focusRound(kRuleMatches);
+    const double focusNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - focusStart).count() / kRuleMatches;
+    Logger::setLevel(logLevel);
+    windowMonitor.stop();
+
+    std::cout << "预设数量: " << presetNames.size() << ", 查找次数: " << kLookups << std::endl;
+    std::cout << "map 查找:   " << legacyNs << " ns/次 (校验和 " << legacyChecksum << ")" << std::endl;
+    std::cout << "动作表查找: " << tableNs << " ns/次 (校验和 " << tableChecksum << ")" << std::endl;
+    std::cout << "加速比: " << legacyNs / tableNs << "x" << std::endl;
+    std::cout << "解码+映射: " << decodeNs << " ns/字节, " << 1e3 / decodeNs << " M字节/s (生成 "
+              << writer.stats().events << " 个事件)" << std::endl;
+    std::cout << "窗口规则 (" << kRulePatterns.size() << " 个模式): DFA " << dfaRuleNs << " ns/窗口, std::regex "
+              << regexRuleNs << " ns/窗口, 加速比 " << regexRuleNs / dfaRuleNs << "x (匹配 " << dfaMatched << "/"
+              << regexMatched << ")" << std::endl;
+    std::cout << "焦点切换: " << focusNs << " ns/次 (校验和 " << focusChecksum << ")" << std::endl;
+
+    if (!tempDirectory.empty()) {
+        std::filesystem::remove_all(tempDirectory);
+    }
+    return 0;
+}
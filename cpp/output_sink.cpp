@@ -0,0 +1,107 @@
+#include "output_sink.hpp"
+#include "logger.hpp"
+#include "uinput_helper.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 输出统计信息
+void UinputWriteStats::print() const {
+    LOG_INFO("事件输出统计: %llu 次写入, %llu 个事件, 平均每次 %.2f 个事件, 失败 %llu 次, 部分写入 %llu 次, 丢弃 %llu 个事件",
+             static_cast<unsigned long long>(writes), static_cast<unsigned long long>(events),
+             writes > 0 ? static_cast<double>(events) / static_cast<double>(writes) : 0.0,
+             static_cast<unsigned long long>(errors), static_cast<unsigned long long>(partialWrites),
+             static_cast<unsigned long long>(droppedEvents));
+}
+
+// 用尽量少的 write 把事件全部写出
+static void writeEvents(int fileDescriptor, std::span<const struct input_event> events, UinputWriteStats& stats) {
+    const char* data = reinterpret_cast<const char*>(events.data());
+    size_t remaining = events.size_bytes();
+
+    while (remaining > 0) {
+        ssize_t written = write(fileDescriptor, data, remaining);
+        stats.writes++;
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 只在第一次失败时输出，避免设备异常时刷屏，其余情况计入统计
+            if (stats.errors++ == 0) {
+                LOG_ERROR("写入事件失败: %s", strerror(errno));
+            }
+            stats.droppedEvents += remaining / sizeof(struct input_event);
+            return;
+        }
+
+        stats.events += static_cast<size_t>(written) / sizeof(struct input_event);
+        if (static_cast<size_t>(written) < remaining) {
+            stats.partialWrites++;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+}
+
+void UinputSink::write(std::span<const struct input_event> events, UinputWriteStats& stats) {
+    writeEvents(m_fileDescriptor, events, stats);
+}
+
+void UinputSink::close() {
+    destroyUinput(m_fileDescriptor);
+    m_fileDescriptor = -1;
+}
+
+void FileSink::write(std::span<const struct input_event> events, UinputWriteStats& stats) {
+    writeEvents(m_fileDescriptor, events, stats);
+}
+
+void FileSink::close() {
+    if (m_fileDescriptor >= 0) {
+        ::close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+}
+
+// 解析输出目标名称
+bool parseSinkKind(const std::string& text, SinkKind& kind) {
+    if (text == "uinput") {
+        kind = SinkKind::Uinput;
+    } else if (text == "null") {
+        kind = SinkKind::Null;
+    } else if (text == "file") {
+        kind = SinkKind::File;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 创建输出目标
+bool openOutputSink(SinkKind kind, const std::string& path, const std::vector<int>& keyCodes, OutputSink& sink) {
+    switch (kind) {
+        case SinkKind::Uinput: {
+            const int fileDescriptor = setupUinput(keyCodes);
+            if (fileDescriptor < 0) {
+                return false;
+            }
+            sink.emplace<UinputSink>(fileDescriptor);
+            return true;
+        }
+        case SinkKind::File: {
+            const int fileDescriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fileDescriptor < 0) {
+                LOG_ERROR("打开输出文件 %s 失败: %s", path.c_str(), strerror(errno));
+                return false;
+            }
+            sink.emplace<FileSink>(fileDescriptor);
+            return true;
+        }
+        case SinkKind::Null:
+            sink.emplace<NullSink>();
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+#include <linux/input.h>
+
+// 事件输出的写入统计
+struct UinputWriteStats {
+    uint64_t writes = 0;         // write 系统调用次数
+    uint64_t events = 0;         // 成功写出的事件数
+    uint64_t errors = 0;         // 写入失败次数
+    uint64_t partialWrites = 0;  // 只写出部分数据的次数
+    uint64_t droppedEvents = 0;  // 因写入失败而丢弃的事件数
+
+    // 输出统计信息
+    void print() const;
+};
+
+// 输出目标
+// 每种目标都提供 write(events, stats) 和 close()，由 UinputWriter 在 flush 时通过 std::visit 分发：
+// 没有虚函数，每批事件只有一次跳转，各目标的写入逻辑可以被内联
+
+// 虚拟输入设备，close() 时销毁设备
+class UinputSink {
+public:
+    explicit UinputSink(int fileDescriptor) : m_fileDescriptor(fileDescriptor) {}
+
+    void write(std::span<const struct input_event> events, UinputWriteStats& stats);
+    void close();
+
+    int fileDescriptor() const { return m_fileDescriptor; }
+
+private:
+    int m_fileDescriptor;
+};
+
+// 把 input_event 记录原样写入文件（或管道）
+class FileSink {
+public:
+    explicit FileSink(int fileDescriptor) : m_fileDescriptor(fileDescriptor) {}
+
+    void write(std::span<const struct input_event> events, UinputWriteStats& stats);
+    void close();
+
+    int fileDescriptor() const { return m_fileDescriptor; }
+
+private:
+    int m_fileDescriptor;
+};
+
+// 丢弃所有事件，只计数，用于测量解码和映射本身的吞吐量
+class NullSink {
+public:
+    void write(std::span<const struct input_event> events, UinputWriteStats& stats) {
+        stats.writes++;
+        stats.events += events.size();
+    }
+    void close() {}
+};
+
+// 把事件保存在内存中，供测试检查生成的事件序列；事件一直累积到 clear()，因此不能在运行时选择
+class MemorySink {
+public:
+    void write(std::span<const struct input_event> events, UinputWriteStats& stats) {
+        stats.writes++;
+        stats.events += events.size();
+        m_events.insert(m_events.end(), events.begin(), events.end());
+    }
+    void close() {}
+
+    const std::vector<struct input_event>& events() const { return m_events; }
+    void clear() { m_events.clear(); }
+
+private:
+    std::vector<struct input_event> m_events;
+};
+
+using OutputSink = std::variant<UinputSink, NullSink, MemorySink, FileSink>;
+
+// 运行时可选择的输出目标
+enum class SinkKind : uint8_t {
+    Uinput,
+    Null,
+    File,
+};
+
+// 解析 uinput/null/file，失败返回 false
+bool parseSinkKind(const std::string& text, SinkKind& kind);
+
+// 创建输出目标：uinput 按 keyCodes 创建虚拟输入设备，file 打开（截断）path；失败返回 false
+bool openOutputSink(SinkKind kind, const std::string& path, const std::vector<int>& keyCodes, OutputSink& sink);
+
+// 关闭输出目标
+inline void closeOutputSink(OutputSink& sink) {
+    std::visit([](auto& target) { target.close(); }, sink);
+}
+
+#endif // OUTPUT_SINK_HPP
@@ -0,0 +1,575 @@
+#include "pattern_matcher.hpp"
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <map>
+
+namespace {
+
+using CharSet = std::bitset<256>;
+
+// Thompson NFA 的一个状态：字符转移（chars 非空时）或若干 ε 转移
+struct NfaState {
+    CharSet chars;
+    int next = -1;
+    std::vector<int> epsilon;
+};
+
+// NFA 片段：从 start 进入，从 end 离开（end 还没有出边）
+struct Fragment {
+    int start;
+    int end;
+};
+
+CharSet allChars() {
+    return CharSet().set();
+}
+
+CharSet charRange(int first, int last) {
+    CharSet chars;
+    for (int c = first; c <= last; ++c) {
+        chars.set(static_cast<size_t>(c));
+    }
+    return chars;
+}
+
+// 只含一个字符的集合中的那个字符
+int singleChar(const CharSet& set) {
+    for (int c = 0; c < 256; ++c) {
+        if (set[static_cast<size_t>(c)]) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+// 把模式解析为 NFA，再用子集构造转换为 DFA
+class PatternCompiler {
+public:
+    explicit PatternCompiler(bool caseInsensitive) : m_caseInsensitive(caseInsensitive) {}
+
+    bool parseRegex(std::string_view pattern, Fragment& result);
+    bool parseGlob(std::string_view pattern, Fragment& result);
+    Fragment literal(std::string_view text);
+    Fragment anyString() { return star(chars(allChars())); }
+    Fragment concat(Fragment first, Fragment second);
+
+    // 子集构造
+    bool build(Fragment fragment, PatternMatcher& matcher);
+
+    std::string error;
+
+private:
+    int addState();
+    Fragment chars(const CharSet& set);
+    Fragment empty();
+    Fragment alternate(Fragment first, Fragment second);
+    Fragment star(Fragment inner);
+    Fragment plus(Fragment inner);
+    Fragment optional(Fragment inner);
+
+    // 不区分大小写时加入另一种大小写
+    CharSet fold(CharSet set) const;
+
+    bool parseBranches(bool topLevel, Fragment& result);
+    bool parseSequence(bool topLevel, Fragment& result, bool& anchoredEnd);
+    bool parseAtom(Fragment& result);
+    bool parseEscape(CharSet& set);
+    bool parseClassItem(bool glob, CharSet& item);
+    bool parseClass(bool glob, CharSet& set);
+    bool fail(const char* message);
+
+    // ε 闭包
+    std::vector<int> closure(std::vector<int> states) const;
+
+    bool m_caseInsensitive;
+    std::vector<NfaState> m_states;
+    std::string_view m_pattern;
+    size_t m_position = 0;
+};
+
+int PatternCompiler::addState() {
+    m_states.emplace_back();
+    return static_cast<int>(m_states.size() - 1);
+}
+
+Fragment PatternCompiler::chars(const CharSet& set) {
+    const int start = addState();
+    const int end = addState();
+    m_states[start].chars = set;
+    m_states[start].next = end;
+    return {start, end};
+}
+
+Fragment PatternCompiler::empty() {
+    const int state = addState();
+    return {state, state};
+}
+
+Fragment PatternCompiler::concat(Fragment first, Fragment second) {
+    m_states[first.end].epsilon.push_back(second.start);
+    return {first.start, second.end};
+}
+
+Fragment PatternCompiler::alternate(Fragment first, Fragment second) {
+    const int start = addState();
+    const int end = addState();
+    m_states[start].epsilon = {first.start, second.start};
+    m_states[first.end].epsilon.push_back(end);
+    m_states[second.end].epsilon.push_back(end);
+    return {start, end};
+}
+
+Fragment PatternCompiler::star(Fragment inner) {
+    const int start = addState();
+    const int end = addState();
+    m_states[start].epsilon = {inner.start, end};
+    m_states[inner.end].epsilon.push_back(inner.start);
+    m_states[inner.end].epsilon.push_back(end);
+    return {start, end};
+}
+
+Fragment PatternCompiler::plus(Fragment inner) {
+    const int end = addState();
+    m_states[inner.end].epsilon.push_back(inner.start);
+    m_states[inner.end].epsilon.push_back(end);
+    return {inner.start, end};
+}
+
+Fragment PatternCompiler::optional(Fragment inner) {
+    const int start = addState();
+    m_states[start].epsilon = {inner.start, inner.end};
+    return {start, inner.end};
+}
+
+CharSet PatternCompiler::fold(CharSet set) const {
+    if (!m_caseInsensitive) {
+        return set;
+    }
+    for (int c = 'a'; c <= 'z'; ++c) {
+        const size_t lower = static_cast<size_t>(c);
+        const size_t upper = static_cast<size_t>(c - 'a' + 'A');
+        if (set[lower] || set[upper]) {
+            set.set(lower);
+            set.set(upper);
+        }
+    }
+    return set;
+}
+
+bool PatternCompiler::fail(const char* message) {
+    error = std::string(message) + "（位置 " + std::to_string(m_position) + "）";
+    return false;
+}
+
+Fragment PatternCompiler::literal(std::string_view text) {
+    Fragment result = empty();
+    for (unsigned char c : text) {
+        result = concat(result, chars(fold(CharSet().set(c))));
+    }
+    return result;
+}
+
+// 解析正则表达式：每个顶层分支按自己的 ^/$ 补上前后的任意字符串，整体按完整匹配编译
+bool PatternCompiler::parseRegex(std::string_view pattern, Fragment& result) {
+    m_pattern = pattern;
+    m_position = 0;
+    if (!parseBranches(true, result)) {
+        return false;
+    }
+    if (m_position != m_pattern.size()) {
+        return fail("多余的 )");
+    }
+    return true;
+}
+
+bool PatternCompiler::parseBranches(bool topLevel, Fragment& result) {
+    bool first = true;
+    while (true) {
+        const bool anchoredStart = topLevel && m_position < m_pattern.size() && m_pattern[m_position] == '^';
+        if (anchoredStart) {
+            ++m_position;
+        }
+
+        Fragment branch;
+        bool anchoredEnd = false;
+        if (!parseSequence(topLevel, branch, anchoredEnd)) {
+            return false;
+        }
+        if (topLevel && !anchoredStart) {
+            branch = concat(anyString(), branch);
+        }
+        if (topLevel && !anchoredEnd) {
+            branch = concat(branch, anyString());
+        }
+
+        result = first ? branch : alternate(result, branch);
+        first = false;
+
+        if (m_position < m_pattern.size() && m_pattern[m_position] == '|') {
+            ++m_position;
+            continue;
+        }
+        return true;
+    }
+}
+
+bool PatternCompiler::parseSequence(bool topLevel, Fragment& result, bool& anchoredEnd) {
+    result = empty();
+    while (m_position < m_pattern.size()) {
+        const char c = m_pattern[m_position];
+        if (c == '|' || c == ')') {
+            break;
+        }
+        if (c == '$') {
+            const bool branchEnd = m_position + 1 == m_pattern.size() || m_pattern[m_position + 1] == '|';
+            if (!topLevel || !branchEnd) {
+                return fail("$ 只能出现在顶层分支的末尾");
+            }
+            ++m_position;
+            anchoredEnd = true;
+            break;
+        }
+        if (c == '^') {
+            return fail("^ 只能出现在顶层分支的开头");
+        }
+
+        Fragment atom;
+        if (!parseAtom(atom)) {
+            return false;
+        }
+        while (m_position < m_pattern.size()) {
+            const char quantifier = m_pattern[m_position];
+            if (quantifier == '*') {
+                atom = star(atom);
+            } else if (quantifier == '+') {
+                atom = plus(atom);
+            } else if (quantifier == '?') {
+                atom = optional(atom);
+            } else if (quantifier == '{') {
+                return fail("不支持 {m,n} 重复，字面的 { 请写成 \\{");
+            } else {
+                break;
+            }
+            ++m_position;
+        }
+        result = concat(result, atom);
+    }
+    return true;
+}
+
+bool PatternCompiler::parseAtom(Fragment& result) {
+    const char c = m_pattern[m_position++];
+    switch (c) {
+        case '(': {
+            if (m_pattern.substr(m_position, 2) == "?:") {
+                m_position += 2;
+            }
+            if (!parseBranches(false, result)) {
+                return false;
+            }
+            if (m_position >= m_pattern.size() || m_pattern[m_position] != ')') {
+                return fail("缺少 )");
+            }
+            ++m_position;
+            return true;
+        }
+        case '[': {
+            CharSet set;
+            if (!parseClass(false, set)) {
+                return false;
+            }
+            result = chars(set);
+            return true;
+        }
+        case '.':
+            result = chars(allChars());
+            return true;
+        case '\\': {
+            CharSet set;
+            if (!parseEscape(set)) {
+                return false;
+            }
+            result = chars(fold(set));
+            return true;
+        }
+        case '*':
+        case '+':
+        case '?':
+            --m_position;
+            return fail("量词前缺少内容");
+        default:
+            result = chars(fold(CharSet().set(static_cast<unsigned char>(c))));
+            return true;
+    }
+}
+
+// 解析 \ 之后的转义
+bool PatternCompiler::parseEscape(CharSet& set) {
+    if (m_position >= m_pattern.size()) {
+        return fail("\\ 后缺少字符");
+    }
+
+    const char c = m_pattern[m_position++];
+    const CharSet digits = charRange('0', '9');
+    const CharSet word = digits | charRange('a', 'z') | charRange('A', 'Z') | CharSet().set('_');
+    const CharSet space = CharSet().set(' ').set('\t').set('\n').set('\r').set('\f').set('\v');
+
+    switch (c) {
+        case 'd': set = digits; return true;
+        case 'D': set = ~digits; return true;
+        case 'w': set = word; return true;
+        case 'W': set = ~word; return true;
+        case 's': set = space; return true;
+        case 'S': set = ~space; return true;
+        case 'n': set = CharSet().set('\n'); return true;
+        case 't': set = CharSet().set('\t'); return true;
+        case 'r': set = CharSet().set('\r'); return true;
+        default:
+            if (std::isalnum(static_cast<unsigned char>(c))) {
+                --m_position;
+                return fail("不支持的转义");
+            }
+            set = CharSet().set(static_cast<unsigned char>(c));
+            return true;
+    }
+}
+
+// 解析字符集中的一项：单个字符、转义字符，或正则中的 \d 等简写
+bool PatternCompiler::parseClassItem(bool glob, CharSet& item) {
+    char c = m_pattern[m_position++];
+    if (c == '\\' && !glob) {
+        return parseEscape(item);
+    }
+    if (c == '\\' && m_position < m_pattern.size()) {
+        c = m_pattern[m_position++];
+    }
+    item = CharSet().set(static_cast<unsigned char>(c));
+    return true;
+}
+
+// 解析 [ 之后的字符集，通配符中用 ! 取反且没有 \d 等简写
+bool PatternCompiler::parseClass(bool glob, CharSet& set) {
+    bool negate = false;
+    if (m_position < m_pattern.size() && (m_pattern[m_position] == '^' || (glob && m_pattern[m_position] == '!'))) {
+        negate = true;
+        ++m_position;
+    }
+
+    bool first = true;
+    while (true) {
+        if (m_position >= m_pattern.size()) {
+            return fail("缺少 ]");
+        }
+        if (m_pattern[m_position] == ']' && !first) {
+            ++m_position;
+            break;
+        }
+        first = false;
+
+        CharSet item;
+        if (!parseClassItem(glob, item)) {
+            return false;
+        }
+
+        // 范围 a-z：单个字符后跟 - 和非 ] 的字符，两端都可以是转义字符
+        const bool range = item.count() == 1 && m_position + 1 < m_pattern.size() && m_pattern[m_position] == '-'
+            && m_pattern[m_position + 1] != ']';
+        if (range) {
+            ++m_position;
+            CharSet highItem;
+            if (!parseClassItem(glob, highItem)) {
+                return false;
+            }
+            if (highItem.count() != 1) {
+                return fail("字符范围的端点必须是单个字符");
+            }
+            const int low = singleChar(item);
+            const int high = singleChar(highItem);
+            if (high < low) {
+                return fail("字符范围顺序错误");
+            }
+            item = charRange(low, high);
+        }
+        set |= item;
+    }
+
+    set = fold(set);
+    if (negate) {
+        set.flip();
+    }
+    return true;
+}
+
+// 解析通配符，总是匹配整个字符串
+bool PatternCompiler::parseGlob(std::string_view pattern, Fragment& result) {
+    m_pattern = pattern;
+    m_position = 0;
+    result = empty();
+
+    while (m_position < m_pattern.size()) {
+        const char c = m_pattern[m_position++];
+        if (c == '*') {
+            result = concat(result, anyString());
+        } else if (c == '?') {
+            result = concat(result, chars(allChars()));
+        } else if (c == '[') {
+            CharSet set;
+            if (!parseClass(true, set)) {
+                return false;
+            }
+            result = concat(result, chars(set));
+        } else {
+            const char literalChar = c == '\\' && m_position < m_pattern.size() ? m_pattern[m_position++] : c;
+            result = concat(result, chars(fold(CharSet().set(static_cast<unsigned char>(literalChar)))));
+        }
+    }
+    return true;
+}
+
+std::vector<int> PatternCompiler::closure(std::vector<int> states) const {
+    std::vector<bool> visited(m_states.size(), false);
+    std::vector<int> pending = std::move(states);
+    std::vector<int> result;
+
+    while (!pending.empty()) {
+        const int state = pending.back();
+        pending.pop_back();
+        if (visited[static_cast<size_t>(state)]) {
+            continue;
+        }
+        visited[static_cast<size_t>(state)] = true;
+        result.push_back(state);
+        for (int next : m_states[static_cast<size_t>(state)].epsilon) {
+            pending.push_back(next);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// 子集构造：字节先按 NFA 中出现的字符集划分为等价类，同一类中的字节转移完全相同
+bool PatternCompiler::build(Fragment fragment, PatternMatcher& matcher) {
+    std::map<std::vector<bool>, uint8_t> classIds;
+    std::vector<unsigned char> representatives;
+    for (size_t byte = 0; byte < 256; ++byte) {
+        std::vector<bool> signature;
+        for (const NfaState& state : m_states) {
+            if (state.next >= 0) {
+                signature.push_back(state.chars[byte]);
+            }
+        }
+        auto [it, inserted] = classIds.try_emplace(std::move(signature), static_cast<uint8_t>(classIds.size()));
+        if (inserted) {
+            representatives.push_back(static_cast<unsigned char>(byte));
+        }
+        matcher.m_byteClass[byte] = it->second;
+    }
+    matcher.m_classCount = representatives.size();
+
+    std::map<std::vector<int>, uint16_t> dfaIds;
+    std::vector<std::vector<int>> dfaStates;
+    auto stateId = [&](std::vector<int> set) -> int {
+        auto it = dfaIds.find(set);
+        if (it != dfaIds.end()) {
+            return it->second;
+        }
+        if (dfaStates.size() >= PatternMatcher::kMaxStates) {
+            return -1;
+        }
+        const uint16_t id = static_cast<uint16_t>(dfaStates.size());
+        dfaIds.emplace(set, id);
+        dfaStates.push_back(std::move(set));
+        return id;
+    };
+
+    stateId(closure({fragment.start}));
+    matcher.m_transitions.clear();
+    for (size_t current = 0; current < dfaStates.size(); ++current) {
+        for (unsigned char byte : representatives) {
+            std::vector<int> targets;
+            for (int state : dfaStates[current]) {
+                const NfaState& nfaState = m_states[static_cast<size_t>(state)];
+                if (nfaState.next >= 0 && nfaState.chars[byte]) {
+                    targets.push_back(nfaState.next);
+                }
+            }
+            const int next = stateId(closure(std::move(targets)));
+            if (next < 0) {
+                error = "模式过于复杂，自动机状态数超过 " + std::to_string(PatternMatcher::kMaxStates);
+                return false;
+            }
+            matcher.m_transitions.push_back(static_cast<uint16_t>(next));
+        }
+    }
+
+    matcher.m_flags.assign(dfaStates.size(), 0);
+    for (size_t state = 0; state < dfaStates.size(); ++state) {
+        if (std::binary_search(dfaStates[state].begin(), dfaStates[state].end(), fragment.end)) {
+            matcher.m_flags[state] |= PatternMatcher::kAccepting;
+        }
+        const auto row = matcher.m_transitions.begin() + static_cast<std::ptrdiff_t>(state * matcher.m_classCount);
+        if (std::all_of(row, row + static_cast<std::ptrdiff_t>(matcher.m_classCount),
+                        [state](uint16_t next) { return next == state; })) {
+            matcher.m_flags[state] |= PatternMatcher::kSink;
+        }
+    }
+    return true;
+}
+
+PatternMatcher::PatternMatcher() : m_transitions{0}, m_flags{kAccepting | kSink} {}
+
+// 编译正则表达式
+bool PatternMatcher::compileRegex(std::string_view pattern, bool caseInsensitive, PatternMatcher& matcher,
+                                  std::string& error) {
+    PatternCompiler compiler(caseInsensitive);
+    Fragment fragment;
+    if (!compiler.parseRegex(pattern, fragment) || !compiler.build(fragment, matcher)) {
+        error = compiler.error;
+        return false;
+    }
+    return true;
+}
+
+// 编译通配符
+bool PatternMatcher::compileGlob(std::string_view pattern, bool caseInsensitive, PatternMatcher& matcher,
+                                 std::string& error) {
+    PatternCompiler compiler(caseInsensitive);
+    Fragment fragment;
+    if (!compiler.parseGlob(pattern, fragment) || !compiler.build(fragment, matcher)) {
+        error = compiler.error;
+        return false;
+    }
+    return true;
+}
+
+// 编译字面字符串
+bool PatternMatcher::compileLiteral(std::string_view text, bool caseInsensitive, bool wholeString,
+                                    PatternMatcher& matcher, std::string& error) {
+    PatternCompiler compiler(caseInsensitive);
+    Fragment fragment = compiler.literal(text);
+    if (!wholeString) {
+        fragment = compiler.concat(compiler.concat(compiler.anyString(), fragment), compiler.anyString());
+    }
+    if (!compiler.build(fragment, matcher)) {
+        error = compiler.error;
+        return false;
+    }
+    return true;
+}
+
+// 匹配整个字符串，到达不再变化的状态后提前结束
+bool PatternMatcher::matches(std::string_view text) const {
+    size_t state = 0;
+    for (unsigned char c : text) {
+        if (m_flags[state] & kSink) {
+            break;
+        }
+        state = m_transitions[state * m_classCount + m_byteClass[c]];
+    }
+    return m_flags[state] & kAccepting;
+}
@@ -0,0 +1,52 @@
+#ifndef PATTERN_MATCHER_HPP
+#define PATTERN_MATCHER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 编译为 DFA 的窗口类名/标题匹配器
+// 加载配置时把正则表达式、通配符、精确匹配或子串匹配编译成一个确定有限自动机，
+// 匹配时每个字节只需一次查表，没有回溯，也不分配内存。
+//
+// 支持的正则语法：字面字符、.、[a-z] / [^...]、\d \w \s \D \W \S 和转义字符、( ) 与 (?: )、|、* + ?，
+// 以及每个分支开头的 ^ 和结尾的 $。没有 ^ 的分支可以从任意位置开始匹配，没有 $ 的分支之后可以有任意内容。
+// 通配符语法：* 任意字符串、? 任意一个字符、[abc] / [!abc]，总是匹配整个字符串。
+class PatternMatcher {
+public:
+    static constexpr size_t kMaxStates = 4096;  // DFA 状态数上限，超出时编译失败
+
+    // 匹配任意字符串
+    PatternMatcher();
+
+    // 编译正则表达式，失败时返回 false 并在 error 中说明原因
+    static bool compileRegex(std::string_view pattern, bool caseInsensitive, PatternMatcher& matcher, std::string& error);
+
+    // 编译通配符
+    static bool compileGlob(std::string_view pattern, bool caseInsensitive, PatternMatcher& matcher, std::string& error);
+
+    // 编译字面字符串：wholeString 为 true 时要求完全相同，否则作为子串出现即可
+    static bool compileLiteral(std::string_view text, bool caseInsensitive, bool wholeString, PatternMatcher& matcher,
+                               std::string& error);
+
+    // 匹配整个字符串
+    bool matches(std::string_view text) const;
+
+    // DFA 状态数
+    size_t stateCount() const { return m_flags.size(); }
+
+private:
+    static constexpr uint8_t kAccepting = 1;
+    static constexpr uint8_t kSink = 2;  // 所有字节都转移到自身，到达后结果不再变化
+
+    friend class PatternCompiler;
+
+    std::array<uint8_t, 256> m_byteClass{};  // 字节 -> 等价类，转移表按等价类存储
+    size_t m_classCount = 1;
+    std::vector<uint16_t> m_transitions;     // 状态 * m_classCount + 等价类
+    std::vector<uint8_t> m_flags;            // 以状态为下标
+};
+
+#endif // PATTERN_MATCHER_HPP
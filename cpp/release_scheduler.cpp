@@ -0,0 +1,198 @@
+#include "release_scheduler.hpp"
+#include "uinput_helper.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kNanosecondsPerTick =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(ReleaseScheduler::kTick).count();
+
+uint64_t monotonicNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+} // namespace
+
+ReleaseScheduler::ReleaseScheduler(UinputWriter& writer)
+    : m_writer(writer) {}
+
+ReleaseScheduler::~ReleaseScheduler() {
+    if (m_timerFd >= 0) {
+        if (m_loop) {
+            m_loop->removeFd(m_timerFd);
+        }
+        close(m_timerFd);
+    }
+}
+
+// 创建 timerfd 并注册到事件循环
+bool ReleaseScheduler::attach(EventLoop& loop) {
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_timerFd < 0) {
+        LOG_ERROR("创建按键释放定时器失败: %s", strerror(errno));
+        return false;
+    }
+
+    if (!loop.addFd(m_timerFd, EPOLLIN, [this](uint32_t) { onTimer(); })) {
+        close(m_timerFd);
+        m_timerFd = -1;
+        return false;
+    }
+
+    m_loop = &loop;
+    m_currentTick = nowTicks() + 1;
+    return true;
+}
+
+uint64_t ReleaseScheduler::nowTicks() {
+    return monotonicNanoseconds() / kNanosecondsPerTick;
+}
+
+// 立即按下按键，并在 holdTime 后释放
+void ReleaseScheduler::tap(int keyCode, std::chrono::milliseconds holdTime) {
+    if (keyCode <= 0 || keyCode >= KEY_CNT) {
+        return;
+    }
+    const uint16_t key = static_cast<uint16_t>(keyCode);
+
+    const uint64_t nowNs = monotonicNanoseconds();
+    advance(nowNs / kNanosecondsPerTick);
+
+    // 同一个按键还没释放又被触发：先释放，否则新的按下事件对内核来说没有变化
+    if (m_pending[key]) {
+        release(key);
+    }
+
+    generateKeyEvent(m_writer, key, 1);
+
+    const uint64_t holdTicks = static_cast<uint64_t>(holdTime / kTick);
+    if (holdTicks == 0 || m_timerFd < 0) {
+        generateKeyEvent(m_writer, key, 0);
+        return;
+    }
+
+    // 到期时间向上取整，保证实际保持时间不短于 holdTime
+    const uint64_t deadline = (nowNs + kNanosecondsPerTick - 1) / kNanosecondsPerTick + holdTicks;
+    const uint64_t delta = deadline - m_currentTick;
+
+    Entry entry;
+    entry.keyCode = key;
+    entry.generation = m_generations[key];
+    entry.rounds = static_cast<uint32_t>(delta / kSlots);
+    m_wheel[(m_currentSlot + delta) % kSlots].push_back(entry);
+    m_entryCount++;
+    m_pending.set(key);
+
+    if (m_armedTick == 0 || deadline < m_armedTick) {
+        rearm();
+    }
+}
+
+// 立即释放所有等待释放的按键
+void ReleaseScheduler::releaseAll() {
+    for (auto& slot : m_wheel) {
+        for (const Entry& entry : slot) {
+            if (m_pending[entry.keyCode] && entry.generation == m_generations[entry.keyCode]) {
+                release(entry.keyCode);
+            }
+        }
+        slot.clear();
+    }
+    m_entryCount = 0;
+    rearm();
+}
+
+// timerfd 到期
+void ReleaseScheduler::onTimer() {
+    uint64_t expirations;
+    if (read(m_timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+
+    m_armedTick = 0;
+    advance(nowTicks());
+    rearm();
+
+    // 同一时刻到期的所有释放事件一起提交
+    m_writer.flush();
+}
+
+// 把时间轮推进到 now，释放所有到期的按键
+void ReleaseScheduler::advance(uint64_t now) {
+    while (m_entryCount > 0 && m_currentTick <= now) {
+        auto& slot = m_wheel[m_currentSlot];
+        size_t kept = 0;
+        for (Entry& entry : slot) {
+            if (entry.rounds > 0) {
+                entry.rounds--;
+                slot[kept++] = entry;
+                continue;
+            }
+            if (m_pending[entry.keyCode] && entry.generation == m_generations[entry.keyCode]) {
+                release(entry.keyCode);
+            }
+        }
+        m_entryCount -= slot.size() - kept;
+        slot.resize(kept);
+
+        m_currentSlot = (m_currentSlot + 1) % kSlots;
+        m_currentTick++;
+    }
+
+    // 时间轮为空时直接跳到当前时间，空闲很久之后也不需要逐格推进
+    if (m_entryCount == 0) {
+        m_currentTick = std::max(m_currentTick, now + 1);
+    }
+}
+
+// 根据最早的到期时间重新设置 timerfd
+void ReleaseScheduler::rearm() {
+    if (m_timerFd < 0) {
+        return;
+    }
+
+    uint64_t deadline = 0;
+    if (m_entryCount > 0) {
+        deadline = std::numeric_limits<uint64_t>::max();
+        for (size_t offset = 0; offset < kSlots; ++offset) {
+            for (const Entry& entry : m_wheel[(m_currentSlot + offset) % kSlots]) {
+                deadline = std::min(deadline, m_currentTick + offset + uint64_t{entry.rounds} * kSlots);
+            }
+        }
+    }
+
+    if (deadline == m_armedTick) {
+        return;
+    }
+
+    // it_value 全零表示解除定时器
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (deadline != 0) {
+        const uint64_t deadlineNs = deadline * kNanosecondsPerTick;
+        spec.it_value.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+        spec.it_value.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+    }
+
+    if (timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        LOG_ERROR("设置按键释放定时器失败: %s", strerror(errno));
+        return;
+    }
+    m_armedTick = deadline;
+}
+
+// 追加释放事件
+void ReleaseScheduler::release(uint16_t keyCode) {
+    generateKeyEvent(m_writer, keyCode, 0);
+    m_pending.reset(keyCode);
+    m_generations[keyCode]++;
+}
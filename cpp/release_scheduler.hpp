@@ -0,0 +1,75 @@
+#ifndef RELEASE_SCHEDULER_HPP
+#define RELEASE_SCHEDULER_HPP
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <linux/input-event-codes.h>
+#include "event_loop.hpp"
+#include "uinput_helper.hpp"
+
+// 按键释放调度器
+// 按下事件立即追加到写入器（随本批次一起提交），释放事件放入以 1ms 为刻度的时间轮，由单个 timerfd 在到期时触发，
+// 事件循环在等待期间可以继续解码新的字节，不再为每个按键阻塞 10ms
+class ReleaseScheduler {
+public:
+    static constexpr std::chrono::milliseconds kTick{1};
+    static constexpr size_t kSlots = 256;  // 时间轮一圈为 256ms，更长的保持时间按圈数计
+
+    explicit ReleaseScheduler(UinputWriter& writer);
+    ~ReleaseScheduler();
+
+    ReleaseScheduler(const ReleaseScheduler&) = delete;
+    ReleaseScheduler& operator=(const ReleaseScheduler&) = delete;
+
+    // 创建 timerfd 并注册到事件循环
+    bool attach(EventLoop& loop);
+
+    // 立即按下按键，并在 holdTime 后释放
+    void tap(int keyCode, std::chrono::milliseconds holdTime);
+
+    // 立即释放所有等待释放的按键（切换配置或退出时调用），由调用者负责 flush
+    void releaseAll();
+
+    // 等待释放的按键数量
+    size_t pendingCount() const { return m_pending.count(); }
+
+private:
+    struct Entry {
+        uint16_t keyCode;
+        uint16_t generation;  // 与 m_generations 不一致说明该按键已被提前释放
+        uint32_t rounds;      // 还需要经过多少圈才到期
+    };
+
+    // 当前单调时钟对应的刻度数（向下取整）
+    static uint64_t nowTicks();
+
+    // timerfd 到期
+    void onTimer();
+
+    // 把时间轮推进到 now，释放所有到期的按键
+    void advance(uint64_t now);
+
+    // 根据最早的到期时间重新设置 timerfd
+    void rearm();
+
+    // 追加释放事件
+    void release(uint16_t keyCode);
+
+    UinputWriter& m_writer;
+    EventLoop* m_loop = nullptr;
+    int m_timerFd = -1;
+
+    std::array<std::vector<Entry>, kSlots> m_wheel;
+    size_t m_currentSlot = 0;
+    uint64_t m_currentTick = 0;  // m_currentSlot 对应的刻度
+    uint64_t m_armedTick = 0;    // timerfd 当前设置的到期刻度，0 表示未设置
+    size_t m_entryCount = 0;     // 时间轮中的条目数（包括已提前释放的过期条目）
+
+    std::bitset<KEY_CNT> m_pending;                // 已按下、等待释放的按键
+    std::array<uint16_t, KEY_CNT> m_generations{}; // 每个按键的释放代数
+};
+
+#endif // RELEASE_SCHEDULER_HPP
@@ -0,0 +1,222 @@
+#include "serial_capture.hpp"
+#include "latency_stats.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+CaptureWriter::~CaptureWriter() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+// 创建（或截断）文件并写入文件头
+bool CaptureWriter::open(const std::string& path) {
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        LOG_ERROR("无法创建捕获文件 %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const uint64_t startTime = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+
+    uint8_t header[capture::kFileHeaderSize];
+    memcpy(header, capture::kMagic, sizeof(capture::kMagic));
+    memcpy(header + sizeof(capture::kMagic), &startTime, sizeof(startTime));
+    if (write(m_fd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+        LOG_ERROR("写入捕获文件头失败: %s", strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// 追加一条记录
+void CaptureWriter::append(uint64_t timestamp, std::span<const uint8_t> first, std::span<const uint8_t> second) {
+    if (m_fd < 0) {
+        return;
+    }
+
+    const uint32_t length = static_cast<uint32_t>(first.size() + second.size());
+    uint8_t header[capture::kRecordHeaderSize];
+    memcpy(header, &timestamp, sizeof(timestamp));
+    memcpy(header + sizeof(timestamp), &length, sizeof(length));
+
+    struct iovec segments[3];
+    segments[0].iov_base = header;
+    segments[0].iov_len = sizeof(header);
+    segments[1].iov_base = const_cast<uint8_t*>(first.data());
+    segments[1].iov_len = first.size();
+    segments[2].iov_base = const_cast<uint8_t*>(second.data());
+    segments[2].iov_len = second.size();
+
+    const ssize_t expected = static_cast<ssize_t>(sizeof(header) + length);
+    ssize_t written;
+    do {
+        written = writev(m_fd, segments, second.empty() ? 2 : 3);
+    } while (written < 0 && errno == EINTR);
+
+    if (written != expected) {
+        // 磁盘写满等情况下停止录制，不影响按键处理
+        LOG_ERROR("写入捕获文件失败，停止录制: %s", written < 0 ? strerror(errno) : "写入不完整");
+        close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_records++;
+}
+
+CaptureFile::~CaptureFile() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+// 映射文件并检查文件头
+bool CaptureFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("无法打开捕获文件 %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) < 0) {
+        LOG_ERROR("无法读取捕获文件信息 %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (static_cast<size_t>(status.st_size) < capture::kFileHeaderSize) {
+        LOG_ERROR("捕获文件 %s 太短", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("映射捕获文件失败: %s", strerror(errno));
+        m_size = 0;
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(mapping);
+    madvise(mapping, m_size, MADV_SEQUENTIAL);
+
+    if (memcmp(m_data, capture::kMagic, sizeof(capture::kMagic)) != 0) {
+        LOG_ERROR("%s 不是捕获文件", path.c_str());
+        return false;
+    }
+
+    m_offset = capture::kFileHeaderSize;
+    return true;
+}
+
+// 读取下一条记录
+bool CaptureFile::next(CaptureChunk& chunk) {
+    if (!m_data || m_offset >= m_size) {
+        return false;
+    }
+
+    uint32_t length;
+    if (m_size - m_offset < capture::kRecordHeaderSize) {
+        m_truncated = true;
+        return false;
+    }
+    memcpy(&chunk.timestamp, m_data + m_offset, sizeof(chunk.timestamp));
+    memcpy(&length, m_data + m_offset + sizeof(chunk.timestamp), sizeof(length));
+    if (m_size - m_offset - capture::kRecordHeaderSize < length) {
+        m_truncated = true;
+        return false;
+    }
+
+    chunk.bytes = std::span<const uint8_t>(m_data + m_offset + capture::kRecordHeaderSize, length);
+    m_offset += capture::kRecordHeaderSize + length;
+    return true;
+}
+
+CaptureReplayer::CaptureReplayer(CaptureFile& file) : m_file(file) {}
+
+CaptureReplayer::~CaptureReplayer() {
+    stop();
+}
+
+// 开始回放
+bool CaptureReplayer::start(EventLoop& loop, double speed, ChunkCallback onChunk, FinishedCallback onFinished) {
+    m_loop = &loop;
+    m_speed = speed;
+    m_onChunk = std::move(onChunk);
+    m_onFinished = std::move(onFinished);
+
+    m_hasNext = m_file.next(m_next);
+    m_firstTimestamp = m_hasNext ? m_next.timestamp : 0;
+    m_startTime = monotonicNanoseconds();
+
+    m_timer = m_loop->addTimer(std::chrono::nanoseconds::zero(), [this]() { onTimer(); });
+    if (m_timer == EventLoop::kInvalidTimer) {
+        m_loop = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// 停止回放
+void CaptureReplayer::stop() {
+    if (m_loop) {
+        m_loop->cancelTimer(m_timer);
+        m_timer = EventLoop::kInvalidTimer;
+        m_loop = nullptr;
+    }
+}
+
+// 记录在回放时间轴上的到期时间
+uint64_t CaptureReplayer::dueTime(uint64_t timestamp) const {
+    if (m_speed <= 0) {
+        return 0;
+    }
+    const uint64_t elapsed = timestamp > m_firstTimestamp ? timestamp - m_firstTimestamp : 0;
+    return m_startTime + static_cast<uint64_t>(static_cast<double>(elapsed) / m_speed);
+}
+
+// 处理所有已到期的记录，并为下一条记录设置定时器
+void CaptureReplayer::onTimer() {
+    m_timer = EventLoop::kInvalidTimer;
+
+    const uint64_t now = monotonicNanoseconds();
+    size_t processed = 0;
+    while (m_hasNext && dueTime(m_next.timestamp) <= now && processed < kBatchLimit) {
+        m_onChunk(m_next);
+        m_chunks++;
+        m_bytes += m_next.bytes.size();
+        processed++;
+        m_hasNext = m_file.next(m_next);
+    }
+
+    if (!m_hasNext) {
+        if (m_file.truncated()) {
+            LOG_WARN("捕获文件的最后一条记录不完整，已忽略");
+        }
+        m_loop = nullptr;
+        m_onFinished();
+        return;
+    }
+
+    const uint64_t due = dueTime(m_next.timestamp);
+    const uint64_t current = monotonicNanoseconds();
+    const auto delay = std::chrono::nanoseconds(due > current ? due - current : 0);
+    m_timer = m_loop->addTimer(delay, [this]() { onTimer(); });
+    if (m_timer == EventLoop::kInvalidTimer) {
+        LOG_ERROR("回放定时器创建失败，停止回放");
+        m_loop = nullptr;
+        m_onFinished();
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef SERIAL_CAPTURE_HPP
+#define SERIAL_CAPTURE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include "event_loop.hpp"
+
+// 串口数据捕获文件格式（本机字节序）
+//   文件头 16 字节: 8 字节魔数 "TBXCAP01"，8 字节录制开始时的 CLOCK_REALTIME 纳秒数（仅供参考）
+//   之后是连续的记录，每条对应一次串口读取:
+//     8 字节 CLOCK_MONOTONIC 纳秒时间戳，4 字节长度，随后是读到的原始字节
+// 记录头不做对齐，读取时用 memcpy 取出，数据部分可以直接引用映射的内存
+namespace capture {
+    constexpr char kMagic[8] = {'T', 'B', 'X', 'C', 'A', 'P', '0', '1'};
+    constexpr size_t kFileHeaderSize = 16;
+    constexpr size_t kRecordHeaderSize = 12;
+}
+
+// 一条捕获记录，bytes 指向映射的文件内容
+struct CaptureChunk {
+    uint64_t timestamp;
+    std::span<const uint8_t> bytes;
+};
+
+// 录制串口数据
+// 每次读取用一次 writev 追加到文件末尾，不在用户态缓存，驱动程序异常退出时已读取的数据也不会丢失
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // 创建（或截断）文件并写入文件头
+    bool open(const std::string& path);
+
+    // 追加一条记录；环形缓冲区中的数据可能分成两段
+    void append(uint64_t timestamp, std::span<const uint8_t> first, std::span<const uint8_t> second = {});
+
+    uint64_t recordCount() const { return m_records; }
+
+private:
+    int m_fd = -1;
+    uint64_t m_records = 0;
+};
+
+// 只读映射的捕获文件，按顺序返回记录
+class CaptureFile {
+public:
+    CaptureFile() = default;
+    ~CaptureFile();
+
+    CaptureFile(const CaptureFile&) = delete;
+    CaptureFile& operator=(const CaptureFile&) = delete;
+
+    // 映射文件并检查文件头
+    bool open(const std::string& path);
+
+    // 读取下一条记录，文件结束或记录不完整时返回 false
+    bool next(CaptureChunk& chunk);
+
+    // 是否因为记录不完整而提前结束（录制时被强制终止）
+    bool truncated() const { return m_truncated; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    bool m_truncated = false;
+};
+
+// 在事件循环中按记录的时间间隔回放捕获文件
+// speed 为 1 时按原速回放，2 时两倍速，0 表示尽快回放（每次最多处理 kBatchLimit 条记录后让出事件循环，
+// 使按键释放等定时器有机会运行）
+class CaptureReplayer {
+public:
+    using ChunkCallback = std::function<void(const CaptureChunk& chunk)>;
+    using FinishedCallback = std::function<void()>;
+
+    static constexpr size_t kBatchLimit = 256;
+
+    explicit CaptureReplayer(CaptureFile& file);
+    ~CaptureReplayer();
+
+    CaptureReplayer(const CaptureReplayer&) = delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+
+    // 开始回放，所有记录处理完后调用 onFinished
+    bool start(EventLoop& loop, double speed, ChunkCallback onChunk, FinishedCallback onFinished);
+
+    // 停止回放
+    void stop();
+
+    uint64_t chunkCount() const { return m_chunks; }
+    uint64_t byteCount() const { return m_bytes; }
+
+private:
+    // 处理所有已到期的记录，并为下一条记录设置定时器
+    void onTimer();
+
+    // 记录在回放时间轴上的到期时间
+    uint64_t dueTime(uint64_t timestamp) const;
+
+    CaptureFile& m_file;
+    EventLoop* m_loop = nullptr;
+    double m_speed = 1.0;
+    ChunkCallback m_onChunk;
+    FinishedCallback m_onFinished;
+    EventLoop::TimerId m_timer = EventLoop::kInvalidTimer;
+
+    CaptureChunk m_next{};
+    bool m_hasNext = false;
+    uint64_t m_firstTimestamp = 0;
+    uint64_t m_startTime = 0;
+    uint64_t m_chunks = 0;
+    uint64_t m_bytes = 0;
+};
+
+#endif // SERIAL_CAPTURE_HPP
@@ -0,0 +1,92 @@
+#include "serial_reader.hpp"
+#include "logger.hpp"
+#include <bit>
+#include <cerrno>
+#include <string>
+#include <sys/uio.h>
+
+// 平均每次读取的字节数
+double SerialReadStats::averageBytesPerRead() const {
+    if (readCalls == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(bytesRead) / static_cast<double>(readCalls);
+}
+
+// 输出统计信息
+void SerialReadStats::print() const {
+    LOG_INFO("输入读取统计: %llu 次读取, %llu 字节, 平均每次 %.2f 字节, 单次最多 %zu 字节",
+             static_cast<unsigned long long>(readCalls), static_cast<unsigned long long>(bytesRead),
+             averageBytesPerRead(), maxBytesPerRead);
+
+    std::string distribution;
+    for (size_t i = 0; i < burstHistogram.size(); ++i) {
+        if (burstHistogram[i] == 0) {
+            continue;
+        }
+        const size_t low = size_t{1} << i;
+        distribution += " [" + std::to_string(low);
+        if (i + 1 == burstHistogram.size()) {
+            distribution += "+";
+        } else {
+            distribution += "-" + std::to_string((low << 1) - 1);
+        }
+        distribution += "]=" + std::to_string(burstHistogram[i]);
+    }
+    LOG_INFO("每次读取字节数分布:%s", distribution.c_str());
+}
+
+SerialReader::SerialReader(int fileDescriptor) : m_fileDescriptor(fileDescriptor) {}
+
+// 读取当前所有可用数据
+ssize_t SerialReader::drain() {
+    ssize_t total = 0;
+
+    while (m_size < kCapacity) {
+        // 环形缓冲区的空闲空间最多分成两段
+        const size_t tail = (m_head + m_size) % kCapacity;
+        const size_t freeSpace = kCapacity - m_size;
+        const size_t firstLength = std::min(freeSpace, kCapacity - tail);
+
+        struct iovec segments[2];
+        segments[0].iov_base = m_buffer.data() + tail;
+        segments[0].iov_len = firstLength;
+        segments[1].iov_base = m_buffer.data();
+        segments[1].iov_len = freeSpace - firstLength;
+        const int segmentCount = segments[1].iov_len > 0 ? 2 : 1;
+
+        ssize_t bytesRead = readv(m_fileDescriptor, segments, segmentCount);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return total > 0 ? total : -1;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+
+        m_size += static_cast<size_t>(bytesRead);
+        total += bytesRead;
+        recordRead(static_cast<size_t>(bytesRead));
+
+        // 没有填满空闲空间说明内核缓冲区已经读空，无需再调用一次 read 等待 EAGAIN
+        if (static_cast<size_t>(bytesRead) < freeSpace) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+void SerialReader::recordRead(size_t bytes) {
+    m_stats.readCalls++;
+    m_stats.bytesRead += bytes;
+    m_stats.maxBytesPerRead = std::max(m_stats.maxBytesPerRead, bytes);
+
+    const size_t bucket = std::min<size_t>(std::bit_width(bytes) - 1, m_stats.burstHistogram.size() - 1);
+    m_stats.burstHistogram[bucket]++;
+}
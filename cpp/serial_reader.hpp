@@ -0,0 +1,76 @@
+#ifndef SERIAL_READER_HPP
+#define SERIAL_READER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <sys/types.h>
+
+// 串口读取统计
+struct SerialReadStats {
+    uint64_t readCalls = 0;      // 读到数据的 read 调用次数
+    uint64_t bytesRead = 0;      // 读取的总字节数
+    size_t maxBytesPerRead = 0;  // 单次读取的最大字节数
+
+    // 每次读取字节数的分布: [1], [2,3], [4,7], [8,15], ... 最后一档包含更大的值
+    std::array<uint64_t, 8> burstHistogram{};
+
+    // 平均每次读取的字节数
+    double averageBytesPerRead() const;
+
+    // 输出统计信息
+    void print() const;
+};
+
+// 串口批量读取器
+// 每次唤醒时用一次 readv 把内核缓冲区中所有可用字节读入环形缓冲区，
+// 传输层用 peek() 以最多两段连续内存交给回调，回调返回后再 discard()
+class SerialReader {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    explicit SerialReader(int fileDescriptor);
+
+    // 读取当前所有可用数据，返回读取的字节数；0 表示没有数据，-1 表示出错（errno 有效）
+    ssize_t drain();
+
+    // 将未处理的字节以最多两段连续内存交给 consumer，不清空缓冲区
+    template <typename Consumer>
+    size_t peek(Consumer&& consumer) const {
+        const size_t total = m_size;
+        if (total == 0) {
+            return 0;
+        }
+
+        const size_t firstLength = std::min(m_size, kCapacity - m_head);
+        consumer(std::span<const uint8_t>(m_buffer.data() + m_head, firstLength));
+        if (firstLength < total) {
+            consumer(std::span<const uint8_t>(m_buffer.data(), total - firstLength));
+        }
+        return total;
+    }
+
+    // 丢弃所有未处理的字节
+    void discard() {
+        m_head = (m_head + m_size) % kCapacity;
+        m_size = 0;
+    }
+
+    // 缓冲区中未处理的字节数
+    size_t pending() const { return m_size; }
+
+    const SerialReadStats& stats() const { return m_stats; }
+
+private:
+    void recordRead(size_t bytes);
+
+    int m_fileDescriptor;
+    std::array<uint8_t, kCapacity> m_buffer;
+    size_t m_head = 0;  // 第一个未处理字节的位置
+    size_t m_size = 0;  // 未处理字节数
+    SerialReadStats m_stats;
+};
+
+#endif // SERIAL_READER_HPP
@@ -0,0 +1,74 @@
+#include "string_interner.hpp"
+#include <algorithm>
+#include <string>
+
+StringInterner::StringInterner() = default;
+
+// 空字符串的句柄
+InternedString StringInterner::empty() {
+    static const size_t emptyHash = std::hash<std::string_view>{}(std::string_view());
+    return InternedString{0, emptyHash, std::string_view()};
+}
+
+// 查找或加入字符串
+InternedString StringInterner::intern(std::string_view text) {
+    if (text.empty()) {
+        return empty();
+    }
+
+    auto it = m_entries.find(text);
+    if (it != m_entries.end()) {
+        return it->second;
+    }
+
+    const std::string_view stored = store(text);
+    const InternedString interned{m_nextId++, std::hash<std::string_view>{}(stored), stored};
+    m_entries.emplace(stored, interned);
+    return interned;
+}
+
+// 把字符串复制到缓冲区中，超过块大小四分之一的字符串单独分配，不浪费当前块的剩余空间
+std::string_view StringInterner::store(std::string_view text) {
+    if (text.size() > kChunkSize / 4) {
+        m_chunks.push_back(std::make_unique<char[]>(text.size()));
+        std::copy(text.begin(), text.end(), m_chunks.back().get());
+        return std::string_view(m_chunks.back().get(), text.size());
+    }
+
+    if (text.size() > m_remaining) {
+        m_chunks.push_back(std::make_unique<char[]>(kChunkSize));
+        m_cursor = m_chunks.back().get();
+        m_remaining = kChunkSize;
+    }
+
+    char* destination = m_cursor;
+    std::copy(text.begin(), text.end(), destination);
+    m_cursor += text.size();
+    m_remaining -= text.size();
+    return std::string_view(destination, text.size());
+}
+
+// 清除除 keep 以外的所有字符串
+void StringInterner::retainOnly(std::initializer_list<InternedString*> keep) {
+    // 保留的字符串还指向旧的缓冲区，先复制出来
+    std::vector<std::string> texts;
+    for (const InternedString* interned : keep) {
+        texts.emplace_back(interned->text);
+    }
+
+    m_entries.clear();
+    m_chunks.clear();
+    m_cursor = nullptr;
+    m_remaining = 0;
+
+    size_t index = 0;
+    for (InternedString* interned : keep) {
+        const std::string& text = texts[index++];
+        if (text.empty() || m_entries.count(text)) {
+            interned->text = text.empty() ? std::string_view() : m_entries.find(text)->second.text;
+            continue;
+        }
+        interned->text = store(text);
+        m_entries.emplace(interned->text, *interned);
+    }
+}
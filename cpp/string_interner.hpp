@@ -0,0 +1,57 @@
+#ifndef STRING_INTERNER_HPP
+#define STRING_INTERNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 驻留字符串的句柄
+// 同一个驻留表中 id 相同当且仅当内容相同，比较两个字符串只需比较 id。
+// id 不会重复使用（清空驻留表后也一样），其他地方缓存的 id 只会不再命中，不会误判为相等
+struct InternedString {
+    uint32_t id = 0;        // 0 是空字符串
+    size_t hash = 0;        // 预先计算的 std::hash<std::string_view>
+    std::string_view text;  // 指向驻留表中的存储，只在被清除前有效
+
+    bool operator==(const InternedString& other) const { return id == other.id; }
+};
+
+// 字符串驻留表（只能在一个线程中使用）
+// 字符串只在第一次出现时复制到按块分配的缓冲区中，之后再次出现只需一次哈希查找，不分配内存
+class StringInterner {
+public:
+    static constexpr size_t kChunkSize = 16 * 1024;
+
+    StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    // 空字符串的句柄
+    static InternedString empty();
+
+    // 查找或加入字符串
+    InternedString intern(std::string_view text);
+
+    // 清除除 keep 以外的所有字符串；保留的字符串 id 和哈希不变，text 更新为新的存储位置
+    void retainOnly(std::initializer_list<InternedString*> keep);
+
+    // 字符串数（不含空字符串）
+    size_t size() const { return m_entries.size(); }
+
+private:
+    // 把字符串复制到缓冲区中
+    std::string_view store(std::string_view text);
+
+    std::unordered_map<std::string_view, InternedString> m_entries;  // 键指向缓冲区中的存储
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    char* m_cursor = nullptr;  // 当前块中下一个空闲位置
+    size_t m_remaining = 0;    // 当前块中剩余的字节数
+    uint32_t m_nextId = 1;
+};
+
+#endif // STRING_INTERNER_HPP
@@ -0,0 +1,332 @@
+// 按钮解码测试：ButtonDecoder 和 UinputWriter 写入 MemorySink，检查生成的事件帧
+
+#include <string>
+#include <variant>
+#include <vector>
+#include "button_decoder.hpp"
+#include "logger.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+// 把配置写入临时目录，返回配置文件路径
+std::string writeConfig(const TempDirectory& directory, std::string_view config) {
+    const std::string path = directory.path() + "/config.json";
+    writeFile(path, config);
+    return path;
+}
+
+// 解码器和它写入的内存输出目标；释放调度器和宏播放器没有接入事件循环，点按和宏的所有步骤立即写出
+struct DecoderFixture {
+    explicit DecoderFixture(std::string_view config) : configManager(writeConfig(directory, config)) {}
+
+    // 提交缓冲区，取出并清空已写出的事件
+    std::vector<std::string> take() {
+        writer.flush();
+        MemorySink& sink = std::get<MemorySink>(writer.sink());
+        std::vector<std::string> events = describeEvents(sink.events());
+        sink.clear();
+        return events;
+    }
+
+    // 解码一批字节并结束本批，两批之间间隔 1 秒，转动不会触发加速
+    void decodeBatch(std::initializer_list<uint8_t> codes, int presetId = ConfigManager::kDefaultPresetId) {
+        for (uint8_t code : codes) {
+            decoder.decode(code, presetId, timestamp);
+        }
+        decoder.endBatch();
+        timestamp += 1000000000ull;
+    }
+
+    TempDirectory directory;
+    ConfigManager configManager;
+    UinputWriter writer{OutputSink{MemorySink()}};
+    ReleaseScheduler scheduler{writer};
+    MacroPlayer macros{writer};
+    KeyHolderCounts keyHolders{};
+    ButtonDecoder decoder{configManager, writer, scheduler, macros, keyHolders};
+    uint64_t timestamp = 1000000000ull;
+};
+
+// 一批输入中的所有帧一起交给输出目标
+void testFramesWrittenPerBatch() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT", "83": "KEY_A"}}})");
+
+    fixture.decodeBatch({0x81, 0x83});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 1), kSyn, keyEvent(KEY_A, 1), kSyn});
+    CHECK(fixture.writer.stats().writes == 1);
+    CHECK(fixture.writer.stats().events == 4);
+
+    fixture.decodeBatch({0x03, 0x01});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 0), kSyn, keyEvent(KEY_LEFTSHIFT, 0), kSyn});
+    CHECK(fixture.writer.stats().writes == 2);
+    CHECK(fixture.decoder.heldCount() == 0);
+}
+
+// 没有映射的代码不产生事件，也不会提交空的写入
+void testUnmappedCodes() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT"}}})");
+
+    fixture.decodeBatch({0x80, 0x00, 0x7E});
+    CHECK_EVENTS(fixture.take(), {});
+    CHECK(fixture.writer.stats().writes == 0);
+}
+
+// 按钮按住期间映射的按键一直按住，转动点按的按键在这期间按下和释放
+void testHeldKeyAroundTap() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT", "44": "KEY_A"}}})");
+
+    fixture.decodeBatch({0x81});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 1), kSyn});
+    CHECK(fixture.decoder.heldCount() == 1);
+
+    fixture.decodeBatch({0x44});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn, keyEvent(KEY_A, 0), kSyn});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 0), kSyn});
+    CHECK(fixture.decoder.heldCount() == 0);
+}
+
+// 丢失了释放码时再次按下，先释放上一次按住的按键；多余的释放码被忽略
+void testLostRelease() {
+    DecoderFixture fixture(R"({"presets": {"default": {"83": "KEY_A"}}})");
+
+    fixture.decodeBatch({0x83, 0x83});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn, keyEvent(KEY_A, 0), kSyn, keyEvent(KEY_A, 1), kSyn});
+
+    fixture.decodeBatch({0x03, 0x03});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 0), kSyn});
+}
+
+// 两个按钮映射同一个键：第一个按下时按下，最后一个松开时才释放
+void testSharedKey() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT", "83": "KEY_LEFTSHIFT"}}})");
+
+    fixture.decodeBatch({0x81, 0x83});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 1), kSyn});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {});
+
+    fixture.decodeBatch({0x03});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 0), kSyn});
+}
+
+// 共用一个输出的两台设备按住同一个键：一台松开时不能释放另一台仍按住的按键
+void testSharedKeyAcrossDevices() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT"}}})");
+    ButtonDecoder second{fixture.configManager, fixture.writer, fixture.scheduler, fixture.macros,
+                         fixture.keyHolders};
+
+    fixture.decodeBatch({0x81});
+    second.decode(0x81, ConfigManager::kDefaultPresetId, fixture.timestamp);
+    second.endBatch();
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 1), kSyn});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {});
+
+    second.releaseAll();
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 0), kSyn});
+    CHECK(second.heldCount() == 0);
+}
+
+// 释放时使用按下时记录的键码，即使期间切换了预设
+void testReleaseAfterPresetChange() {
+    DecoderFixture fixture(R"({"presets": {"default": {"83": "KEY_A"}, "other": {"83": "KEY_B"}}})");
+    const int other = fixture.configManager.findPresetId("other");
+
+    fixture.decodeBatch({0x83}, ConfigManager::kDefaultPresetId);
+    fixture.decodeBatch({0x03}, other);
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn, keyEvent(KEY_A, 0), kSyn});
+}
+
+// releaseAll 释放所有按住的按键，之后到达的释放码不再输出
+void testReleaseAll() {
+    DecoderFixture fixture(R"({"presets": {"default": {"81": "KEY_LEFTSHIFT", "83": "KEY_A"}}})");
+
+    fixture.decodeBatch({0x81, 0x83});
+    fixture.take();
+    fixture.decoder.releaseAll();
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 0), kSyn, keyEvent(KEY_A, 0), kSyn});
+    CHECK(fixture.decoder.heldCount() == 0);
+
+    fixture.decodeBatch({0x01, 0x03});
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// 同一批字节中同一轴的鼠标移动累加为一个 EV_REL，两个轴共用一个 SYN_REPORT
+void testMotionCoalescedPerBatch() {
+    DecoderFixture fixture(R"({"presets": {"default": {"49": "REL_Y_NEG", "09": "REL_Y_POS", "4F": "REL_X_POS"}}})");
+
+    fixture.decodeBatch({0x49, 0x49, 0x4F, 0x49});
+    CHECK_EVENTS(fixture.take(), {relEvent(REL_X, kRelativeStep), relEvent(REL_Y, -3 * kRelativeStep), kSyn});
+    CHECK(fixture.decoder.stats().relativeSteps == 4);
+    CHECK(fixture.decoder.stats().relativeFrames == 1);
+}
+
+// 正反方向相互抵消时不写出
+void testOppositeMotionCancels() {
+    DecoderFixture fixture(R"({"presets": {"default": {"49": "REL_Y_NEG", "09": "REL_Y_POS"}}})");
+
+    fixture.decodeBatch({0x49, 0x09});
+    CHECK_EVENTS(fixture.take(), {});
+    CHECK(fixture.decoder.stats().cancelledFrames == 1);
+    CHECK(fixture.decoder.stats().relativeFrames == 0);
+}
+
+// 按键事件之前先写出已经累积的移动，保持输入顺序
+void testMotionFlushedBeforeKey() {
+    DecoderFixture fixture(R"({"presets": {"default": {"49": "REL_Y_NEG", "44": "KEY_A"}}})");
+
+    fixture.decodeBatch({0x49, 0x49, 0x44, 0x49});
+    CHECK_EVENTS(fixture.take(), {relEvent(REL_Y, -2 * kRelativeStep), kSyn, keyEvent(KEY_A, 1), kSyn,
+                                  keyEvent(KEY_A, 0), kSyn, relEvent(REL_Y, -kRelativeStep), kSyn});
+    CHECK(fixture.decoder.stats().relativeFrames == 2);
+}
+
+// 设置了合并时间窗时，多批字节中的移动在时间窗结束时合并写出
+void testCoalesceWindowAcrossBatches() {
+    EventLoop loop;  // 解码器析构时要取消定时器，事件循环必须比它后销毁
+    DecoderFixture fixture(R"({"presets": {"default": {"49": "REL_Y_NEG"}}, "coalesce_window_us": 20000})");
+    fixture.decoder.setCoalesceWindow(loop, fixture.configManager.getCoalesceWindow());
+
+    const auto start = std::chrono::steady_clock::now();
+    fixture.decodeBatch({0x49});
+    fixture.decodeBatch({0x49, 0x49});
+    CHECK_EVENTS(fixture.take(), {});
+
+    MemorySink& sink = std::get<MemorySink>(fixture.writer.sink());
+    CHECK(runLoopUntil(loop, [&]() { return !sink.events().empty(); }));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+    CHECK_EVENTS(fixture.take(), {relEvent(REL_Y, -3 * kRelativeStep), kSyn});
+    CHECK(fixture.decoder.stats().relativeFrames == 1);
+}
+
+constexpr std::string_view kChordConfig = R"({"presets": {
+    "default": {
+        "80": "KEY_LEFTSHIFT",
+        "81": "KEY_LEFTCTRL",
+        "82": "KEY_B",
+        "83": "KEY_A",
+        "44": "KEY_RIGHTBRACE",
+        "81+44": "KEY_KPPLUS",
+        "81+83": "KEY_X",
+        "82+83": "KEY_Y"
+    },
+    "other": {
+        "80": "KEY_C",
+        "80+44": "KEY_D"
+    }
+}})";
+
+// 按住修饰按钮时转动查和弦层，修饰按钮自己按下和松开时都不输出
+void testChordLayer() {
+    DecoderFixture fixture(kChordConfig);
+
+    fixture.decodeBatch({0x81});
+    CHECK_EVENTS(fixture.take(), {});
+    CHECK(fixture.decoder.modifiers() == chordModifierBit(0x81));
+
+    fixture.decodeBatch({0x44});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_KPPLUS, 1), kSyn, keyEvent(KEY_KPPLUS, 0), kSyn});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {});
+    CHECK(fixture.decoder.modifiers() == 0);
+
+    // 松开修饰按钮之后恢复普通映射
+    fixture.decodeBatch({0x44});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_RIGHTBRACE, 1), kSyn, keyEvent(KEY_RIGHTBRACE, 0), kSyn});
+}
+
+// 按钮和弦：按住修饰按钮时另一个按钮按住和弦映射的按键，松开时释放同一个键
+void testButtonChord() {
+    DecoderFixture fixture(kChordConfig);
+
+    fixture.decodeBatch({0x81, 0x83});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_X, 1), kSyn});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {});
+
+    fixture.decodeBatch({0x03});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_X, 0), kSyn});
+}
+
+// 单独按一下修饰按钮时，松开时点按它自己的映射
+void testDeferredModifierTapsOnRelease() {
+    DecoderFixture fixture(kChordConfig);
+
+    fixture.decodeBatch({0x81});
+    CHECK_EVENTS(fixture.take(), {});
+
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTCTRL, 1), kSyn, keyEvent(KEY_LEFTCTRL, 0), kSyn});
+}
+
+// 多个修饰按钮的组合没有对应的和弦时，使用修饰按钮最多的子集和弦
+void testChordSubsetFallback() {
+    DecoderFixture fixture(kChordConfig);
+
+    fixture.decodeBatch({0x81, 0x82, 0x44});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_KPPLUS, 1), kSyn, keyEvent(KEY_KPPLUS, 0), kSyn});
+
+    // 两个修饰按钮都参与了和弦，松开时都不触发自己的映射
+    fixture.decodeBatch({0x02, 0x01});
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// 只在某个预设的和弦中用作修饰的按钮，在其他预设中仍然随按钮按住和释放
+void testModifiersPerPreset() {
+    DecoderFixture fixture(kChordConfig);
+    const int other = fixture.configManager.findPresetId("other");
+
+    fixture.decodeBatch({0x80});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 1), kSyn});
+    fixture.decodeBatch({0x00});
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTSHIFT, 0), kSyn});
+
+    fixture.decodeBatch({0x80}, other);
+    CHECK_EVENTS(fixture.take(), {});
+    fixture.decodeBatch({0x44}, other);
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_D, 1), kSyn, keyEvent(KEY_D, 0), kSyn});
+    fixture.decodeBatch({0x00}, other);
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// 按住修饰按钮时 releaseAll（切换预设）之后，松开修饰按钮不再触发推迟的映射
+void testReleaseAllCancelsDeferredModifier() {
+    DecoderFixture fixture(kChordConfig);
+
+    fixture.decodeBatch({0x81});
+    fixture.decoder.releaseAll();
+    fixture.decodeBatch({0x01});
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+} // namespace
+
+int main() {
+    Logger::setLevel(LogLevel::Warn);
+    testFramesWrittenPerBatch();
+    testUnmappedCodes();
+    testHeldKeyAroundTap();
+    testLostRelease();
+    testSharedKey();
+    testSharedKeyAcrossDevices();
+    testReleaseAfterPresetChange();
+    testReleaseAll();
+    testMotionCoalescedPerBatch();
+    testOppositeMotionCancels();
+    testMotionFlushedBeforeKey();
+    testCoalesceWindowAcrossBatches();
+    testChordLayer();
+    testButtonChord();
+    testDeferredModifierTapsOnRelease();
+    testChordSubsetFallback();
+    testModifiersPerPreset();
+    testReleaseAllCancelsDeferredModifier();
+    return testResult();
+}
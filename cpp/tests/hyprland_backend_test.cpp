@@ -0,0 +1,124 @@
+// Hyprland 后端测试：在临时目录中模拟 .socket.sock 和 .socket2.sock，
+// 回放 activewindow/activewindowv2 事件（包括被拆开的行和含逗号的标题），并检查异步查询不会阻塞事件循环
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "test_support.hpp"
+#include "window_backend.hpp"
+
+namespace {
+
+using Window = std::pair<std::string, std::string>;
+
+// 接受一个连接，读取请求后等待 delay 再返回 reply 并关闭
+std::thread serveQuery(int listener, std::chrono::milliseconds delay, std::string reply) {
+    return std::thread([listener, delay, reply = std::move(reply)]() {
+        int client = accept(listener, nullptr, nullptr);
+        char request[64];
+        ssize_t length = read(client, request, sizeof(request));
+        if (length <= 0 || std::string(request, static_cast<size_t>(length)) != "j/activewindow") {
+            std::fprintf(stderr, "意外的请求\n");
+        }
+        std::this_thread::sleep_for(delay);
+        writeAll(client, reply);
+        close(client);
+    });
+}
+
+// 接受事件套接字的连接，依次间隔 10ms 写出每一段
+std::thread serveEvents(int listener, std::chrono::milliseconds initialDelay, std::vector<std::string> chunks) {
+    return std::thread([listener, initialDelay, chunks = std::move(chunks)]() {
+        int client = accept(listener, nullptr, nullptr);
+        std::this_thread::sleep_for(initialDelay);
+        for (const std::string& chunk : chunks) {
+            writeAll(client, chunk);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        // 保持连接直到后端断开
+        char byte;
+        while (read(client, &byte, 1) > 0) {
+        }
+        close(client);
+    });
+}
+
+// 查询结果先到，之后的事件按行拆开发送
+void testQueryAndEvents() {
+    TempDirectory directory;
+    int queryListener = listenUnixSocket(directory.path() + "/.socket.sock");
+    int eventListener = listenUnixSocket(directory.path() + "/.socket2.sock");
+
+    std::thread query = serveQuery(queryListener, std::chrono::milliseconds(200), R"({"class": "kitty", "title": "~"})");
+    std::thread events = serveEvents(eventListener, std::chrono::milliseconds(400), {
+        "activewindow>>firef",
+        "ox,Title, with, commas\nactivewindowv2>>55d0a1b2c3d4\nworkspace>>2\n",
+        "activewindow>>Gimp,\n",
+        "activewindow>>,\nactivewindowv2>>\n",
+    });
+
+    EventLoop loop;
+    std::vector<Window> windows;
+    HyprlandBackend backend(directory.path());
+    CHECK(backend.start(loop, [&](std::string_view windowClass, std::string_view windowTitle) {
+        windows.emplace_back(windowClass, windowTitle);
+    }));
+
+    // 查询回复之前事件循环仍在运行
+    bool timerFiredBeforeReply = false;
+    loop.addTimer(std::chrono::milliseconds(50), [&]() { timerFiredBeforeReply = windows.empty(); });
+
+    CHECK(runLoopUntil(loop, [&]() { return windows.size() >= 5; }));
+    backend.stop();
+    query.join();
+    events.join();
+    close(queryListener);
+    close(eventListener);
+
+    CHECK(timerFiredBeforeReply);
+    const std::vector<Window> expected = {
+        {"kitty", "~"},
+        {"firefox", "Title, with, commas"},
+        {"Gimp", ""},
+        {"", ""},
+        {"", ""},
+    };
+    CHECK(windows == expected);
+}
+
+// 查询结果晚于焦点事件到达时被丢弃，不能覆盖更新的窗口
+void testStaleQueryIgnored() {
+    TempDirectory directory;
+    int queryListener = listenUnixSocket(directory.path() + "/.socket.sock");
+    int eventListener = listenUnixSocket(directory.path() + "/.socket2.sock");
+
+    std::thread query = serveQuery(queryListener, std::chrono::milliseconds(300), R"({"class": "stale", "title": "old"})");
+    std::thread events = serveEvents(eventListener, std::chrono::milliseconds(50), {"activewindow>>firefox,New\n"});
+
+    EventLoop loop;
+    std::vector<Window> windows;
+    HyprlandBackend backend(directory.path());
+    backend.start(loop, [&](std::string_view windowClass, std::string_view windowTitle) {
+        windows.emplace_back(windowClass, windowTitle);
+    });
+
+    // 等到查询的回复肯定已经发出
+    runLoopUntil(loop, []() { return false; }, std::chrono::milliseconds(500));
+    backend.stop();
+    query.join();
+    events.join();
+    close(queryListener);
+    close(eventListener);
+
+    const std::vector<Window> expected = {{"firefox", "New"}};
+    CHECK(windows == expected);
+}
+
+} // namespace
+
+int main() {
+    testQueryAndEvents();
+    testStaleQueryIgnored();
+    return testResult();
+}
@@ -0,0 +1,85 @@
+// 异步日志测试：多个线程写日志的同时停止后台线程，每条日志要么输出、要么计入丢弃数，不能丢失
+
+#include <atomic>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+constexpr int kThreads = 4;
+constexpr int kMessagesPerThread = 20000;
+
+// 统计文件中以 "msg " 开头的行数
+size_t countMessages(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(file, line)) {
+        if (line.rfind("msg ", 0) == 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void testStopWhileLogging() {
+    TempDirectory directory;
+    const std::string outputPath = directory.path() + "/stdout.txt";
+
+    // 把标准输出重定向到文件
+    fflush(stdout);
+    const int savedStdout = dup(STDOUT_FILENO);
+    const int output = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    dup2(output, STDOUT_FILENO);
+    close(output);
+
+    const uint64_t droppedBefore = Logger::droppedCount();
+    Logger::start();
+
+    std::atomic<int> started{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kThreads; ++thread) {
+        threads.emplace_back([&, thread]() {
+            started.fetch_add(1);
+            for (int i = 0; i < kMessagesPerThread; ++i) {
+                LOG_INFO("msg %d %d", thread, i);
+            }
+        });
+    }
+
+    // 日志还在写入时停止后台线程，之后的日志改为同步输出
+    while (started.load() < kThreads) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    Logger::stop();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+
+    const uint64_t dropped = Logger::droppedCount() - droppedBefore;
+    const size_t written = countMessages(outputPath);
+    if (written + dropped != static_cast<size_t>(kThreads) * kMessagesPerThread) {
+        std::fprintf(stderr, "输出 %zu 条，丢弃 %llu 条，共应有 %d 条\n", written,
+                     static_cast<unsigned long long>(dropped), kThreads * kMessagesPerThread);
+    }
+    CHECK(written + dropped == static_cast<size_t>(kThreads) * kMessagesPerThread);
+}
+
+} // namespace
+
+int main() {
+    for (int round = 0; round < 20; ++round) {
+        testStopWhileLogging();
+    }
+    return testResult();
+}
@@ -0,0 +1,141 @@
+// 宏测试：宏在加载配置时编译为事件帧，播放时第一段立即写出，有延迟的段由事件循环的定时器按时写出
+
+#include <string>
+#include <variant>
+#include <vector>
+#include "config_manager.hpp"
+#include "logger.hpp"
+#include "macro.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view kConfig = R"({"presets": {"default": {
+    "81": "KEY_LEFTCTRL+KEY_Z",
+    "82": {"macro": ["KEY_LEFTCTRL+KEY_S", {"delay_ms": 40}, "KEY_ESC"], "hold_ms": 10}
+}}})";
+
+struct MacroFixture {
+    MacroFixture() : configManager(configPath()) { macros.attach(loop); }
+
+    std::string configPath() {
+        const std::string path = directory.path() + "/config.json";
+        writeFile(path, kConfig);
+        return path;
+    }
+
+    const Macro& macro(uint8_t buttonCode) {
+        return configManager.getMacro(configManager.getAction(buttonCode, ConfigManager::kDefaultPresetId).macroId);
+    }
+
+    MemorySink& sink() { return std::get<MemorySink>(writer.sink()); }
+
+    // 提交缓冲区，取出并清空已写出的事件
+    std::vector<std::string> take() {
+        writer.flush();
+        std::vector<std::string> events = describeEvents(sink().events());
+        sink().clear();
+        return events;
+    }
+
+    // 运行事件循环直到定时器写出新的一段，返回距 start 的时间
+    Clock::duration waitForStep(Clock::time_point start) {
+        CHECK(runLoopUntil(loop, [this]() { return !sink().events().empty(); }));
+        return Clock::now() - start;
+    }
+
+    TempDirectory directory;
+    ConfigManager configManager;
+    EventLoop loop;
+    UinputWriter writer{OutputSink{MemorySink()}};
+    MacroPlayer macros{writer};
+};
+
+// 组合键的 hold_ms 为 0：按下和释放在同一次写入中完成，没有等待中的段
+void testChordInOneWrite() {
+    MacroFixture fixture;
+    fixture.macros.play(fixture.macro(0x81));
+    CHECK(fixture.macros.pendingCount() == 0);
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTCTRL, 1), kSyn, keyEvent(KEY_Z, 1), kSyn,
+                                  keyEvent(KEY_Z, 0), kSyn, keyEvent(KEY_LEFTCTRL, 0), kSyn});
+    CHECK(fixture.writer.stats().writes == 1);
+}
+
+// 每一段都不早于它的偏移时间写出：0ms 按下，10ms 释放组合键，50ms 按下 Esc，60ms 释放
+void testStepTiming() {
+    MacroFixture fixture;
+    const auto start = Clock::now();
+    fixture.macros.play(fixture.macro(0x82));
+    CHECK(fixture.macros.pendingCount() == 3);
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_LEFTCTRL, 1), kSyn, keyEvent(KEY_S, 1), kSyn});
+
+    CHECK(fixture.waitForStep(start) >= std::chrono::milliseconds(10));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_S, 0), kSyn, keyEvent(KEY_LEFTCTRL, 0), kSyn});
+
+    CHECK(fixture.waitForStep(start) >= std::chrono::milliseconds(50));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_ESC, 1), kSyn});
+
+    CHECK(fixture.waitForStep(start) >= std::chrono::milliseconds(60));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_ESC, 0), kSyn});
+    CHECK(fixture.macros.pendingCount() == 0);
+}
+
+// finishAll 按到期顺序立即写出所有等待中的段，之后定时器不再写出
+void testFinishAll() {
+    MacroFixture fixture;
+    fixture.macros.play(fixture.macro(0x82));
+    fixture.take();
+
+    fixture.macros.finishAll();
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_S, 0), kSyn, keyEvent(KEY_LEFTCTRL, 0), kSyn,
+                                  keyEvent(KEY_ESC, 1), kSyn, keyEvent(KEY_ESC, 0), kSyn});
+    CHECK(fixture.macros.pendingCount() == 0);
+
+    runLoopUntil(fixture.loop, []() { return false; }, std::chrono::milliseconds(80));
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// 等待中的段是复制出来的，播放期间重新加载配置不影响它们
+void testPendingStepsSurviveReload() {
+    MacroFixture fixture;
+    fixture.macros.play(fixture.macro(0x82));
+    fixture.take();
+
+    writeFile(fixture.directory.path() + "/config.json", R"({"presets": {"default": {"83": "KEY_A"}}})");
+    CHECK(fixture.configManager.loadConfig());
+
+    std::vector<std::string> events;
+    CHECK(runLoopUntil(fixture.loop, [&]() {
+        std::vector<std::string> step = fixture.take();
+        events.insert(events.end(), step.begin(), step.end());
+        return fixture.macros.pendingCount() == 0;
+    }));
+    CHECK_EVENTS(events, {keyEvent(KEY_S, 0), kSyn, keyEvent(KEY_LEFTCTRL, 0), kSyn,
+                          keyEvent(KEY_ESC, 1), kSyn, keyEvent(KEY_ESC, 0), kSyn});
+}
+
+// 没有接入事件循环时所有段立即写出
+void testWithoutEventLoop() {
+    MacroFixture fixture;
+    UinputWriter writer{OutputSink{MemorySink()}};
+    MacroPlayer macros(writer);
+    macros.play(fixture.macro(0x82));
+    writer.flush();
+    CHECK_EVENTS(describeEvents(std::get<MemorySink>(writer.sink()).events()),
+                 {keyEvent(KEY_LEFTCTRL, 1), kSyn, keyEvent(KEY_S, 1), kSyn, keyEvent(KEY_S, 0), kSyn,
+                  keyEvent(KEY_LEFTCTRL, 0), kSyn, keyEvent(KEY_ESC, 1), kSyn, keyEvent(KEY_ESC, 0), kSyn});
+}
+
+} // namespace
+
+int main() {
+    Logger::setLevel(LogLevel::Warn);
+    testChordInOneWrite();
+    testStepTiming();
+    testFinishAll();
+    testPendingStepsSurviveReload();
+    testWithoutEventLoop();
+    return testResult();
+}
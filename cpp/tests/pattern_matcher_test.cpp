@@ -0,0 +1,247 @@
+// 模式匹配测试：把 DFA 的匹配结果与 std::regex 在同一组样本上的结果对比
+
+#include <regex>
+#include <string>
+#include <vector>
+#include "pattern_matcher.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+const std::vector<std::string> kSubjects = {
+    "",
+    "a",
+    "-",
+    ".",
+    "5",
+    "Z",
+    "]",
+    "+",
+    "abc",
+    "a-b",
+    "a.b",
+    "x]y",
+    "blend",
+    "scene.blend",
+    "scene.blend1",
+    "Scene.BLEND",
+    "org.kde",
+    "org.kde.dolphin",
+    "ORG.KDE.Konsole",
+    "orgXkdeXfoo",
+    "my.org.kde.app",
+    "firefox",
+    "Firefox",
+    "Mozilla Firefox",
+    "chromium",
+    "report.pdf",
+    "report.pdf.bak",
+    "gimp-2.10",
+    "GIMP-2",
+    "foobar",
+    "barfoo",
+    "color",
+    "colour",
+    "aabbc",
+    "bc",
+    "!x",
+    "*literal",
+    "abaabbab",
+    "babbbbbbbb",
+};
+
+// 正则中有特殊含义的字符
+bool isRegexSpecial(char c) {
+    return std::string_view("\\^$.|?*+()[]{}/-").find(c) != std::string_view::npos;
+}
+
+std::string escapeRegex(std::string_view text) {
+    std::string result;
+    for (char c : text) {
+        if (isRegexSpecial(c)) {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+// 把通配符翻译为等价的 ECMAScript 正则
+std::string globToRegex(std::string_view glob) {
+    std::string result = "^";
+    size_t position = 0;
+    while (position < glob.size()) {
+        const char c = glob[position++];
+        if (c == '*') {
+            result += ".*";
+        } else if (c == '?') {
+            result += ".";
+        } else if (c == '[') {
+            result += "[";
+            if (position < glob.size() && glob[position] == '!') {
+                result += "^";
+                ++position;
+            }
+            bool first = true;
+            while (position < glob.size() && (glob[position] != ']' || first)) {
+                const char member = glob[position++];
+                if (member == '\\' && position < glob.size()) {
+                    result += "\\";
+                    result.push_back(glob[position++]);
+                } else if (member == ']') {
+                    result += "\\]";
+                } else {
+                    result.push_back(member);
+                }
+                first = false;
+            }
+            result += "]";
+            ++position;
+        } else if (c == '\\' && position < glob.size()) {
+            result += escapeRegex(glob.substr(position++, 1));
+        } else {
+            result += escapeRegex(std::string_view(&c, 1));
+        }
+    }
+    return result + "$";
+}
+
+// 在全部样本上对比，regex 按 regex_search 语义（与 compileRegex 一致：未锚定的分支可以匹配子串）
+void compareWithStdRegex(const PatternMatcher& matcher, const std::string& regex, bool caseInsensitive,
+                         const std::string& description) {
+    auto flags = std::regex::ECMAScript;
+    if (caseInsensitive) {
+        flags |= std::regex::icase;
+    }
+    const std::regex reference(regex, flags);
+    for (const std::string& subject : kSubjects) {
+        const bool expected = std::regex_search(subject, reference);
+        if (matcher.matches(subject) != expected) {
+            std::fprintf(stderr, "%s (忽略大小写=%d) 匹配 \"%s\" 的结果应为 %d\n", description.c_str(),
+                         caseInsensitive, subject.c_str(), expected);
+            ++gTestFailures;
+        }
+    }
+}
+
+void testRegexCorpus() {
+    const std::vector<std::string> patterns = {
+        R"(^org\.kde\..*)",
+        R"(\.blend$)",
+        R"(^firefox$|chrom|\.pdf$)",
+        R"(kde|^gimp|foo$)",
+        R"((?:))",
+        R"(^(?:)$)",
+        R"(a(?:)b)",
+        R"((?:foo|bar)+$)",
+        R"([\.-9])",
+        R"(^[\--z]+$)",
+        R"(^[+-\]]$)",
+        R"(^[\w.-]+$)",
+        R"([^a-z])",
+        R"(gimp-[0-9]+\.[0-9]+)",
+        R"(^colou?r$)",
+        R"(^a*b+c?$)",
+        R"(^\d)",
+        R"(\s)",
+        R"(^[\dA-F]+$)",
+    };
+    for (const std::string& pattern : patterns) {
+        for (bool caseInsensitive : {false, true}) {
+            PatternMatcher matcher;
+            std::string error;
+            const bool compiled = PatternMatcher::compileRegex(pattern, caseInsensitive, matcher, error);
+            if (!compiled) {
+                std::fprintf(stderr, "正则 %s 编译失败: %s\n", pattern.c_str(), error.c_str());
+                ++gTestFailures;
+                continue;
+            }
+            compareWithStdRegex(matcher, pattern, caseInsensitive, "正则 " + pattern);
+        }
+    }
+}
+
+void testGlobCorpus() {
+    const std::vector<std::string> globs = {
+        "*.blend",
+        "org.kde.*",
+        "[!.]*",
+        "?[!a-c]*",
+        "*[0-9]*",
+        "[\\!x]*",
+        "\\*literal",
+        "[]]",
+        "a?b",
+        "*",
+        "",
+    };
+    for (const std::string& glob : globs) {
+        for (bool caseInsensitive : {false, true}) {
+            PatternMatcher matcher;
+            std::string error;
+            if (!PatternMatcher::compileGlob(glob, caseInsensitive, matcher, error)) {
+                std::fprintf(stderr, "通配符 %s 编译失败: %s\n", glob.c_str(), error.c_str());
+                ++gTestFailures;
+                continue;
+            }
+            compareWithStdRegex(matcher, globToRegex(glob), caseInsensitive, "通配符 " + glob);
+        }
+    }
+}
+
+void testLiteralCorpus() {
+    const std::vector<std::string> texts = {"kde", "Firefox", "a.b", "]", "", "scene.blend"};
+    for (const std::string& text : texts) {
+        for (bool caseInsensitive : {false, true}) {
+            for (bool wholeString : {false, true}) {
+                PatternMatcher matcher;
+                std::string error;
+                CHECK(PatternMatcher::compileLiteral(text, caseInsensitive, wholeString, matcher, error));
+                const std::string regex = wholeString ? "^" + escapeRegex(text) + "$" : escapeRegex(text);
+                compareWithStdRegex(matcher, regex, caseInsensitive, "字面字符串 " + text);
+            }
+        }
+    }
+}
+
+void testInvalidPatterns() {
+    const std::vector<std::string> patterns = {"[z-a]", "[a-\\d]", "[abc", "(abc", "abc)", "*a", "a{2}", "\\q", "a^b"};
+    for (const std::string& pattern : patterns) {
+        PatternMatcher matcher;
+        std::string error;
+        CHECK(!PatternMatcher::compileRegex(pattern, false, matcher, error));
+        CHECK(!error.empty());
+    }
+}
+
+// 未锚定的 [ab]*a[ab]{n} 需要约 2^(n+1) 个 DFA 状态
+void testStateLimit() {
+    std::string small = "a";
+    for (int i = 0; i < 8; ++i) {
+        small += "[ab]";
+    }
+    PatternMatcher matcher;
+    std::string error;
+    CHECK(PatternMatcher::compileRegex(small, false, matcher, error));
+    CHECK(matcher.stateCount() <= PatternMatcher::kMaxStates);
+    compareWithStdRegex(matcher, small, false, "正则 " + small);
+
+    std::string large = "a";
+    for (int i = 0; i < 12; ++i) {
+        large += "[ab]";
+    }
+    error.clear();
+    CHECK(!PatternMatcher::compileRegex(large, false, matcher, error));
+    CHECK(!error.empty());
+}
+
+} // namespace
+
+int main() {
+    testRegexCorpus();
+    testGlobCorpus();
+    testLiteralCorpus();
+    testInvalidPatterns();
+    testStateLimit();
+    return testResult();
+}
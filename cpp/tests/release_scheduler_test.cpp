@@ -0,0 +1,125 @@
+// 按键释放调度器测试：点按的按键立即按下，由时间轮在保持时间之后释放，不早于保持时间
+
+#include <string>
+#include <variant>
+#include <vector>
+#include "release_scheduler.hpp"
+#include "test_support.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct SchedulerFixture {
+    SchedulerFixture() { scheduler.attach(loop); }
+
+    MemorySink& sink() { return std::get<MemorySink>(writer.sink()); }
+
+    // 提交缓冲区，取出并清空已写出的事件
+    std::vector<std::string> take() {
+        writer.flush();
+        std::vector<std::string> events = describeEvents(sink().events());
+        sink().clear();
+        return events;
+    }
+
+    // 运行事件循环直到定时器写出新的事件
+    bool waitForEvents() {
+        return runLoopUntil(loop, [this]() { return !sink().events().empty(); });
+    }
+
+    EventLoop loop;
+    UinputWriter writer{OutputSink{MemorySink()}};
+    ReleaseScheduler scheduler{writer};
+};
+
+// 释放在保持时间之后由定时器写出
+void testReleaseAfterHold() {
+    SchedulerFixture fixture;
+    const auto start = Clock::now();
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(20));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn});
+    CHECK(fixture.scheduler.pendingCount() == 1);
+
+    CHECK(fixture.waitForEvents());
+    CHECK(Clock::now() - start >= std::chrono::milliseconds(20));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 0), kSyn});
+    CHECK(fixture.scheduler.pendingCount() == 0);
+}
+
+// 不同保持时间的按键按到期顺序释放
+void testExpiryOrder() {
+    SchedulerFixture fixture;
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(40));
+    fixture.scheduler.tap(KEY_B, std::chrono::milliseconds(10));
+    fixture.take();
+
+    CHECK(fixture.waitForEvents());
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_B, 0), kSyn});
+    CHECK(fixture.waitForEvents());
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 0), kSyn});
+}
+
+// 超过时间轮一圈（256ms）的保持时间按圈数计，不会在第一圈提前释放
+void testHoldLongerThanWheel() {
+    SchedulerFixture fixture;
+    const auto start = Clock::now();
+    fixture.scheduler.tap(KEY_C, std::chrono::milliseconds(300));
+    fixture.take();
+
+    CHECK(fixture.waitForEvents());
+    CHECK(Clock::now() - start >= std::chrono::milliseconds(300));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_C, 0), kSyn});
+}
+
+// 还没释放又被点按：先释放再按下，之前安排的释放作废，只在新的保持时间之后释放一次
+void testRetapBeforeRelease() {
+    SchedulerFixture fixture;
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(10));
+    const auto retap = Clock::now();
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(50));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn, keyEvent(KEY_A, 0), kSyn, keyEvent(KEY_A, 1), kSyn});
+
+    CHECK(fixture.waitForEvents());
+    CHECK(Clock::now() - retap >= std::chrono::milliseconds(50));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 0), kSyn});
+
+    runLoopUntil(fixture.loop, []() { return false; }, std::chrono::milliseconds(30));
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// releaseAll 立即释放所有等待中的按键，定时器之后不再写出
+void testReleaseAll() {
+    SchedulerFixture fixture;
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(20));
+    fixture.scheduler.tap(KEY_B, std::chrono::milliseconds(500));
+    fixture.take();
+
+    fixture.scheduler.releaseAll();
+    std::vector<std::string> released = fixture.take();
+    CHECK(released.size() == 4);
+    CHECK(fixture.scheduler.pendingCount() == 0);
+
+    runLoopUntil(fixture.loop, []() { return false; }, std::chrono::milliseconds(50));
+    CHECK_EVENTS(fixture.take(), {});
+}
+
+// 保持时间为 0 时按下和释放一起写出
+void testZeroHold() {
+    SchedulerFixture fixture;
+    fixture.scheduler.tap(KEY_A, std::chrono::milliseconds(0));
+    CHECK_EVENTS(fixture.take(), {keyEvent(KEY_A, 1), kSyn, keyEvent(KEY_A, 0), kSyn});
+    CHECK(fixture.scheduler.pendingCount() == 0);
+}
+
+} // namespace
+
+int main() {
+    testReleaseAfterHold();
+    testExpiryOrder();
+    testHoldLongerThanWheel();
+    testRetapBeforeRelease();
+    testReleaseAll();
+    testZeroHold();
+    return testResult();
+}
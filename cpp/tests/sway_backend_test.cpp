@@ -0,0 +1,160 @@
+// Sway 后端测试：通过 socketpair 向 SwayBackend 发送带 i3-ipc 帧头的回复和事件，
+// 包括被拆开的消息，以及魔数错误、长度异常时断开重连
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include "test_support.hpp"
+#include "window_backend.hpp"
+
+namespace {
+
+using Window = std::pair<std::string, std::string>;
+
+// 连接时依次使用预先创建的 socketpair 一端
+class SocketpairSwayBackend : public SwayBackend {
+public:
+    SocketpairSwayBackend() : SwayBackend("socketpair") {}
+
+    // 创建一对套接字，后端下一次连接时使用其中一端，返回另一端
+    int addConnection() {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) {
+            std::perror("socketpair");
+            std::exit(1);
+        }
+        m_pending.push_back(fds[0]);
+        return fds[1];
+    }
+
+    int connectCount() const { return m_connectCount; }
+
+protected:
+    int connectSocket() override {
+        ++m_connectCount;
+        if (m_pending.empty()) {
+            return -1;
+        }
+        const int fd = m_pending.front();
+        m_pending.pop_front();
+        return fd;
+    }
+
+private:
+    std::deque<int> m_pending;
+    int m_connectCount = 0;
+};
+
+// 读出对端收到的所有数据
+std::string readAvailable(int fd) {
+    std::string data;
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        data.append(buffer, static_cast<size_t>(length));
+    }
+    return data;
+}
+
+// 对端是否已被关闭
+bool peerClosed(int fd) {
+    char byte;
+    return read(fd, &byte, 1) == 0;
+}
+
+// 订阅、查询布局树，然后处理窗口事件
+void testTreeAndEvents() {
+    EventLoop loop;
+    SocketpairSwayBackend backend;
+    const int peer = backend.addConnection();
+
+    std::vector<Window> windows;
+    CHECK(backend.start(loop, [&](std::string_view windowClass, std::string_view windowTitle) {
+        windows.emplace_back(windowClass, windowTitle);
+    }));
+
+    // 连接后先订阅 window 事件，再查询布局树
+    const std::string expectedRequests = SwayBackend::encodeMessage(SwayBackend::kSubscribe, R"(["window"])")
+        + SwayBackend::encodeMessage(SwayBackend::kGetTree, "");
+    CHECK(readAvailable(peer) == expectedRequests);
+
+    const std::string tree = R"({"nodes": [{"nodes": [
+        {"focused": false, "app_id": "kitty", "name": "shell"},
+        {"focused": true, "app_id": null, "window_properties": {"class": "Gimp"}, "name": "GIMP"}
+    ]}]})";
+    const std::string focus = SwayBackend::encodeMessage(SwayBackend::kWindowEvent,
+        R"({"change": "focus", "container": {"app_id": "firefox", "name": "Mozilla, Firefox", "focused": true}})");
+    const std::vector<std::string> chunks = {
+        SwayBackend::encodeMessage(SwayBackend::kSubscribe, R"({"success": true})")
+            + SwayBackend::encodeMessage(SwayBackend::kGetTree, tree),
+        // 帧头和负载都被拆开
+        focus.substr(0, 5),
+        focus.substr(5, 20),
+        focus.substr(25),
+        SwayBackend::encodeMessage(SwayBackend::kWindowEvent,
+            R"({"change": "title", "container": {"app_id": "firefox", "name": "New title", "focused": true}})")
+            + SwayBackend::encodeMessage(SwayBackend::kWindowEvent,
+                R"({"change": "title", "container": {"app_id": "kitty", "name": "bg", "focused": false}})"),
+        SwayBackend::encodeMessage(SwayBackend::kWindowEvent,
+            R"({"change": "close", "container": {"app_id": "firefox", "name": "New title", "focused": true}})"),
+    };
+    for (size_t index = 0; index < chunks.size(); ++index) {
+        loop.addTimer(std::chrono::milliseconds(5 * (index + 1)), [&, index]() { writeAll(peer, chunks[index]); });
+    }
+
+    CHECK(runLoopUntil(loop, [&]() { return windows.size() >= 4; }));
+    const std::vector<Window> expected = {
+        {"Gimp", "GIMP"},
+        {"firefox", "Mozilla, Firefox"},
+        {"firefox", "New title"},
+        {"", ""},
+    };
+    CHECK(windows == expected);
+
+    backend.stop();
+    close(peer);
+}
+
+// 魔数错误或长度超过上限时断开连接，之后重新连接
+void testInvalidHeaderReconnects() {
+    EventLoop loop;
+    SocketpairSwayBackend backend;
+    const int firstPeer = backend.addConnection();
+    const int secondPeer = backend.addConnection();
+
+    std::vector<Window> windows;
+    backend.start(loop, [&](std::string_view windowClass, std::string_view windowTitle) {
+        windows.emplace_back(windowClass, windowTitle);
+    });
+    readAvailable(firstPeer);
+
+    std::string badMagic = SwayBackend::encodeMessage(SwayBackend::kWindowEvent, "{}");
+    badMagic[0] = 'x';
+    writeAll(firstPeer, badMagic);
+    CHECK(runLoopUntil(loop, [&]() { return peerClosed(firstPeer); }));
+
+    // 断开后按退避间隔重连，使用第二个连接
+    CHECK(runLoopUntil(loop, [&]() { return backend.connectCount() >= 2; }));
+    readAvailable(secondPeer);
+
+    std::string oversized = SwayBackend::encodeMessage(SwayBackend::kGetTree, "");
+    const uint32_t length = static_cast<uint32_t>(SwayBackend::kMaxMessageSize + 1);
+    memcpy(oversized.data() + 6, &length, sizeof(length));
+    writeAll(secondPeer, oversized);
+    CHECK(runLoopUntil(loop, [&]() { return peerClosed(secondPeer); }));
+
+    CHECK(windows.empty());
+    backend.stop();
+    close(firstPeer);
+    close(secondPeer);
+}
+
+} // namespace
+
+int main() {
+    testTreeAndEvents();
+    testInvalidHeaderReconnects();
+    return testResult();
+}
@@ -0,0 +1,169 @@
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+// 测试用的断言和辅助函数，不依赖测试框架
+// CHECK 失败时输出位置并计数，不中断测试；每个测试程序的 main 返回 testResult()
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include <linux/input.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "event_loop.hpp"
+
+inline int gTestFailures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            ++gTestFailures;                                                          \
+        }                                                                             \
+    } while (0)
+
+// 测试程序的退出状态
+inline int testResult() {
+    if (gTestFailures > 0) {
+        std::fprintf(stderr, "%d 项检查失败\n", gTestFailures);
+        return 1;
+    }
+    return 0;
+}
+
+// 运行事件循环直到 done() 返回 true，超时返回 false
+inline bool runLoopUntil(EventLoop& loop, const std::function<bool()>& done,
+                         std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) {
+    bool timedOut = false;
+    const auto poll = loop.addTimer(std::chrono::milliseconds(1), [&]() {
+        if (done()) {
+            loop.stop();
+        }
+    }, std::chrono::milliseconds(1));
+    const auto deadline = loop.addTimer(timeout, [&]() {
+        timedOut = true;
+        loop.stop();
+    });
+
+    loop.run();
+    loop.cancelTimer(poll);
+    if (!timedOut) {
+        loop.cancelTimer(deadline);
+    }
+    return !timedOut;
+}
+
+// 测试结束时删除的临时目录
+class TempDirectory {
+public:
+    TempDirectory() {
+        std::string pattern = (std::filesystem::temp_directory_path() / "tourbox_test_XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            std::perror("mkdtemp");
+            std::exit(1);
+        }
+        m_path = pattern;
+    }
+    ~TempDirectory() { std::filesystem::remove_all(m_path); }
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    const std::string& path() const { return m_path; }
+
+private:
+    std::string m_path;
+};
+
+// 在 path 上监听 Unix 域套接字（阻塞），失败时退出
+inline int listenUnixSocket(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), std::min(path.size(), sizeof(address.sun_path) - 1));
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 4) < 0) {
+        std::perror(path.c_str());
+        std::exit(1);
+    }
+    return fd;
+}
+
+// 把所有数据写入套接字，对端已关闭时直接返回
+inline void writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (written <= 0) {
+            return;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+// 写入文本文件（例如测试用的配置），失败时退出
+inline void writeFile(const std::string& path, std::string_view text) {
+    std::ofstream file(path);
+    file << text;
+    if (!file) {
+        std::perror(path.c_str());
+        std::exit(1);
+    }
+}
+
+// 事件的文本形式，便于整段比较和在失败时输出
+inline std::string keyEvent(int code, int value) {
+    return "KEY " + std::to_string(code) + " " + std::to_string(value);
+}
+
+inline std::string relEvent(int code, int value) {
+    return "REL " + std::to_string(code) + " " + std::to_string(value);
+}
+
+inline const std::string kSyn = "SYN";
+
+inline std::vector<std::string> describeEvents(std::span<const struct input_event> events) {
+    std::vector<std::string> result;
+    for (const struct input_event& event : events) {
+        if (event.type == EV_KEY) {
+            result.push_back(keyEvent(event.code, event.value));
+        } else if (event.type == EV_REL) {
+            result.push_back(relEvent(event.code, event.value));
+        } else if (event.type == EV_SYN && event.code == SYN_REPORT) {
+            result.push_back(kSyn);
+        } else {
+            result.push_back("? " + std::to_string(event.type) + " " + std::to_string(event.code) + " "
+                             + std::to_string(event.value));
+        }
+    }
+    return result;
+}
+
+// 比较事件序列，不一致时输出双方内容；期望值可以写成 {keyEvent(...), kSyn} 形式
+inline void checkEvents(const std::vector<std::string>& actual, const std::vector<std::string>& expected,
+                        const char* file, int line) {
+    if (actual == expected) {
+        return;
+    }
+    std::fprintf(stderr, "%s:%d: 事件不一致\n  实际:", file, line);
+    for (const std::string& event : actual) {
+        std::fprintf(stderr, " [%s]", event.c_str());
+    }
+    std::fprintf(stderr, "\n  期望:");
+    for (const std::string& event : expected) {
+        std::fprintf(stderr, " [%s]", event.c_str());
+    }
+    std::fprintf(stderr, "\n");
+    ++gTestFailures;
+}
+
+#define CHECK_EVENTS(actual, ...) checkEvents((actual), __VA_ARGS__, __FILE__, __LINE__)
+
+#endif // TEST_SUPPORT_HPP
@@ -0,0 +1,132 @@
+// 焦点切换路径的堆分配测试：窗口监控器使用真实的 Hyprland 后端，从临时目录中模拟的事件套接字读取焦点事件。
+// 同一组窗口轮流获得焦点，预热后从读取套接字、拆分事件行、驻留、规则缓存到快照发布都不应再有堆分配
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "config_manager.hpp"
+#include "logger.hpp"
+#include "test_support.hpp"
+#include "window_monitor.hpp"
+
+// 统计本进程的所有堆分配
+static std::atomic<uint64_t> gAllocations{0};
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+
+constexpr size_t kRounds = 200;
+
+// 轮流获得焦点的窗口，默认配置中 Gimp 和 Blender 有对应的规则
+const std::vector<std::pair<std::string, std::string>> kWindows = {
+    {"org.kde.dolphin", "Home — Dolphin"},
+    {"Blender", "scene_final_v3.blend"},
+    {"krita", "Untitled - Krita"},
+    {"Gimp", "GNU Image Manipulation Program"},
+    {"firefox", "Mozilla Firefox - 一个很长的网页标题, 包含逗号"},
+    {"kitty", "~/projects"},
+};
+
+void testFocusPathDoesNotAllocate() {
+    TempDirectory directory;
+    ConfigManager configManager(directory.path() + "/config.json");
+    int queryListener = listenUnixSocket(directory.path() + "/.socket.sock");
+    int eventListener = listenUnixSocket(directory.path() + "/.socket2.sock");
+
+    EventLoop loop;
+    WindowMonitor windowMonitor(std::make_unique<HyprlandBackend>(directory.path()));
+
+    // 每轮等待 kWindows.size() 次发布后停止事件循环
+    size_t pendingPublishes = 0;
+    windowMonitor.setPresetResolver([&](const InternedString& windowClass, const InternedString& windowTitle) {
+        if (pendingPublishes > 0 && --pendingPublishes == 0) {
+            loop.stop();
+        }
+        return configManager.resolvePresetId(windowClass, windowTitle);
+    });
+
+    // 后端连接事件套接字后立即查询初始窗口，在这里直接回复
+    windowMonitor.start(loop);
+    int events = accept(eventListener, nullptr, nullptr);
+    int query = accept(queryListener, nullptr, nullptr);
+    char request[64];
+    CHECK(read(query, request, sizeof(request)) > 0);
+    writeAll(query, R"({"class": "kitty", "title": "~"})");
+    close(query);
+    CHECK(runLoopUntil(loop, [&]() { return windowMonitor.snapshot()->version > 0; }));
+
+    // 一轮焦点事件，与 Hyprland 一样每个窗口有 activewindow 和 activewindowv2 两行
+    std::string round;
+    for (const auto& [windowClass, windowTitle] : kWindows) {
+        round += "activewindow>>" + windowClass + "," + windowTitle + "\nactivewindowv2>>55d0a1b2c3d4\n";
+    }
+
+    // 防止事件没有到达时一直阻塞：周期定时器在预热前创建，超时后停止事件循环
+    bool timedOut = false;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    const auto watchdog = loop.addTimer(std::chrono::milliseconds(100), [&]() {
+        if (std::chrono::steady_clock::now() > deadline) {
+            timedOut = true;
+            loop.stop();
+        }
+    }, std::chrono::milliseconds(100));
+
+    const LogLevel logLevel = Logger::level();
+    Logger::setLevel(LogLevel::Warn);  // 不输出每次窗口切换
+    uint64_t defaultPresetWindows = 0;
+    auto focusRounds = [&](size_t rounds) {
+        for (size_t i = 0; i < rounds && !timedOut; ++i) {
+            pendingPublishes = kWindows.size();
+            writeAll(events, round);
+            loop.run();
+            defaultPresetWindows += windowMonitor.snapshot()->presetId == 0;
+        }
+    };
+
+    // 预热：驻留所有字符串，填满规则缓存和快照退役队列，让事件缓冲区增长到所需容量
+    focusRounds(AtomicSnapshot<WindowSnapshot>::kRetiredCapacity + 1);
+
+    const uint64_t allocationsBefore = gAllocations.load(std::memory_order_relaxed);
+    focusRounds(kRounds);
+    const uint64_t allocations = gAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+    Logger::setLevel(logLevel);
+
+    CHECK(!timedOut);
+    CHECK(windowMonitor.snapshot()->version == 1 + (AtomicSnapshot<WindowSnapshot>::kRetiredCapacity + 1 + kRounds) * kWindows.size());
+    // 每轮最后获得焦点的是 kitty，没有对应的规则
+    CHECK(defaultPresetWindows == AtomicSnapshot<WindowSnapshot>::kRetiredCapacity + 1 + kRounds);
+    if (allocations != 0) {
+        std::fprintf(stderr, "焦点切换路径在稳态下有 %llu 次堆分配\n", static_cast<unsigned long long>(allocations));
+    }
+    CHECK(allocations == 0);
+
+    loop.cancelTimer(watchdog);
+    windowMonitor.stop();
+    close(events);
+    close(queryListener);
+    close(eventListener);
+}
+
+} // namespace
+
+int main() {
+    testFocusPathDoesNotAllocate();
+    return testResult();
+}
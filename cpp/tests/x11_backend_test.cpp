@@ -0,0 +1,200 @@
+// X11 后端测试：启动一个 Xvfb，由测试自己扮演窗口管理器设置 _NET_ACTIVE_WINDOW、WM_CLASS 和标题，
+// 检查 X11Backend 报告的窗口。没有安装 Xvfb 时跳过（返回 77）
+
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <utility>
+#include <vector>
+#include <xcb/xcb.h>
+#include "test_support.hpp"
+#include "x11_window_backend.hpp"
+
+namespace {
+
+constexpr int kSkipped = 77;
+
+using Window = std::pair<std::string, std::string>;
+
+// 在 PATH 中查找可执行文件
+bool findExecutable(const char* name) {
+    const char* path = getenv("PATH");
+    std::string directories = path ? path : "";
+    size_t start = 0;
+    while (start <= directories.size()) {
+        size_t end = directories.find(':', start);
+        if (end == std::string::npos) {
+            end = directories.size();
+        }
+        const std::string candidate = directories.substr(start, end - start) + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+// 启动 Xvfb，由它选择空闲的显示编号并通过 -displayfd 告知
+class Xvfb {
+public:
+    bool start() {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            return false;
+        }
+        m_pid = fork();
+        if (m_pid == 0) {
+            close(fds[0]);
+            const std::string displayFd = std::to_string(fds[1]);
+            execlp("Xvfb", "Xvfb", "-displayfd", displayFd.c_str(), "-nolisten", "tcp", "-screen", "0", "640x480x24",
+                   static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(fds[1]);
+
+        std::string number;
+        char byte;
+        while (read(fds[0], &byte, 1) == 1 && byte != '\n') {
+            number.push_back(byte);
+        }
+        close(fds[0]);
+        if (number.empty()) {
+            return false;
+        }
+        m_display = ":" + number;
+        return true;
+    }
+
+    ~Xvfb() {
+        if (m_pid > 0) {
+            kill(m_pid, SIGTERM);
+            waitpid(m_pid, nullptr, 0);
+        }
+    }
+
+    const std::string& display() const { return m_display; }
+
+private:
+    pid_t m_pid = -1;
+    std::string m_display;
+};
+
+// 测试用的 X 客户端，扮演窗口管理器
+class FakeWindowManager {
+public:
+    explicit FakeWindowManager(const std::string& display) {
+        m_connection = xcb_connect(display.c_str(), nullptr);
+        m_screen = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data;
+        m_netActiveWindow = internAtom("_NET_ACTIVE_WINDOW");
+        m_netWmName = internAtom("_NET_WM_NAME");
+        m_utf8String = internAtom("UTF8_STRING");
+    }
+    ~FakeWindowManager() { xcb_disconnect(m_connection); }
+
+    bool connected() const { return !xcb_connection_has_error(m_connection); }
+
+    // 创建窗口并设置 WM_CLASS（"实例名\0类名\0"）
+    xcb_window_t createWindow(std::string_view instance, std::string_view windowClass) {
+        const xcb_window_t window = xcb_generate_id(m_connection);
+        xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, window, m_screen->root, 0, 0, 10, 10, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, m_screen->root_visual, 0, nullptr);
+        std::string wmClass(instance);
+        wmClass.push_back('\0');
+        wmClass.append(windowClass);
+        wmClass.push_back('\0');
+        setProperty(window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8, wmClass.data(), wmClass.size());
+        return window;
+    }
+
+    void setNetWmName(xcb_window_t window, std::string_view title) {
+        setProperty(window, m_netWmName, m_utf8String, 8, title.data(), title.size());
+    }
+
+    void setWmName(xcb_window_t window, std::string_view title) {
+        setProperty(window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, title.data(), title.size());
+    }
+
+    void activate(xcb_window_t window) {
+        setProperty(m_screen->root, m_netActiveWindow, XCB_ATOM_WINDOW, 32, &window, 1);
+    }
+
+private:
+    void setProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type, uint8_t format, const void* data,
+                     size_t length) {
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, property, type, format,
+                            static_cast<uint32_t>(length), data);
+        xcb_flush(m_connection);
+    }
+
+    xcb_atom_t internAtom(const char* atomName) {
+        xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(
+            m_connection, xcb_intern_atom(m_connection, 0, static_cast<uint16_t>(strlen(atomName)), atomName), nullptr);
+        const xcb_atom_t atom = reply ? reply->atom : static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+        free(reply);
+        return atom;
+    }
+
+    xcb_connection_t* m_connection;
+    xcb_screen_t* m_screen;
+    xcb_atom_t m_netActiveWindow;
+    xcb_atom_t m_netWmName;
+    xcb_atom_t m_utf8String;
+};
+
+void testActiveWindowChanges(const std::string& display) {
+    FakeWindowManager windowManager(display);
+    CHECK(windowManager.connected());
+    const xcb_window_t editor = windowManager.createWindow("gimp", "Gimp");
+    windowManager.setNetWmName(editor, "GNU Image Manipulation Program");
+    const xcb_window_t legacy = windowManager.createWindow("xterm", "XTerm");
+    windowManager.setWmName(legacy, "legacy title");
+
+    EventLoop loop;
+    std::vector<Window> windows;
+    X11Backend backend(display);
+    CHECK(backend.start(loop, [&](std::string_view windowClass, std::string_view windowTitle) {
+        windows.emplace_back(windowClass, windowTitle);
+    }));
+
+    // 每一步都等后端报告后再进行下一步
+    const std::vector<std::function<void()>> steps = {
+        [&]() { windowManager.activate(editor); },
+        [&]() { windowManager.setNetWmName(editor, "Renamed"); },
+        [&]() { windowManager.activate(legacy); },
+        [&]() { windowManager.activate(XCB_WINDOW_NONE); },
+    };
+    for (size_t step = 0; step < steps.size(); ++step) {
+        steps[step]();
+        CHECK(runLoopUntil(loop, [&]() { return windows.size() >= step + 2; }));
+    }
+    backend.stop();
+
+    const std::vector<Window> expected = {
+        {"", ""},
+        {"Gimp", "GNU Image Manipulation Program"},
+        {"Gimp", "Renamed"},
+        {"XTerm", "legacy title"},
+        {"", ""},
+    };
+    CHECK(windows == expected);
+}
+
+} // namespace
+
+int main() {
+    if (!findExecutable("Xvfb")) {
+        std::fprintf(stderr, "未找到 Xvfb，跳过 X11 后端测试\n");
+        return kSkipped;
+    }
+
+    Xvfb server;
+    if (!server.start()) {
+        std::fprintf(stderr, "无法启动 Xvfb，跳过 X11 后端测试\n");
+        return kSkipped;
+    }
+
+    testActiveWindowChanges(server.display());
+    return testResult();
+}
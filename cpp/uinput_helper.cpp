@@ -1,66 +1,58 @@
 #include "uinput_helper.hpp"
+#include "logger.hpp"
+#include <filesystem>
 #include <fcntl.h>
 #include <unistd.h>
 #include <cstring>
-#include <iostream>
+
+UinputWriter::UinputWriter(OutputSink sink) : m_sink(std::move(sink)) {}
 
 /**
- * @brief 发送输入事件
- * @param fileDescriptor 文件描述符
- * @param type 事件类型
- * @param code 事件代码
- * @param val 事件值
+ * @brief 把缓冲区中的所有事件一次交给输出目标
  */
-void emit(int fileDescriptor, int type, int code, int val) {
-    struct input_event event;
-    memset(&event, 0, sizeof(event));
-    
-    event.type = type;
-    event.code = code;
-    event.value = val;
-    
-    // 设置时间戳
-    gettimeofday(&event.time, NULL);
-    
-    // 写入事件
-    if (write(fileDescriptor, &event, sizeof(event)) < 0) {
-        std::cerr << "写入事件失败: " << strerror(errno) << std::endl;
+void UinputWriter::flush() {
+    if (m_count == 0) {
+        return;
     }
+    const std::span<const struct input_event> events(m_buffer.data(), m_count);
+    m_count = 0;
+    std::visit([&](auto& sink) { sink.write(events, m_stats); }, m_sink);
 }
 
 /**
- * @brief 根据键码生成按键事件
- * @param fileDescriptor 文件描述符
- * @param keyCode 键码
+ * @brief 生成鼠标移动事件帧（附带 SYN_REPORT）
+ * @param writer 批量写入器
+ * @param keyCode 特殊映射键码 (REL_X_POS 等)
+ * @param distance 移动距离（正数，方向由键码决定）
  */
-void generateKeyPressEvent(int fileDescriptor, int keyCode) {
-    // 处理特殊的鼠标移动映射
+void generateRelativeEvent(UinputWriter& writer, int keyCode, int distance) {
     if (keyCode == REL_X_POS) {
         // 鼠标右移
-        emit(fileDescriptor, EV_REL, REL_X, 10);
-        emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
-        return;
+        writer.append(EV_REL, REL_X, distance);
     } else if (keyCode == REL_X_NEG) {
         // 鼠标左移
-        emit(fileDescriptor, EV_REL, REL_X, -10);
-        emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
-        return;
+        writer.append(EV_REL, REL_X, -distance);
     } else if (keyCode == REL_Y_POS) {
         // 鼠标下移
-        emit(fileDescriptor, EV_REL, REL_Y, 10);
-        emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
-        return;
+        writer.append(EV_REL, REL_Y, distance);
     } else if (keyCode == REL_Y_NEG) {
         // 鼠标上移
-        emit(fileDescriptor, EV_REL, REL_Y, -10);
-        emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
+        writer.append(EV_REL, REL_Y, -distance);
+    } else {
         return;
     }
-    emit(fileDescriptor, EV_KEY, keyCode, 1);  // 按下
-    emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
-    usleep(10000);  // 10ms 延迟
-    emit(fileDescriptor, EV_KEY, keyCode, 0);  // 释放
-    emit(fileDescriptor, EV_SYN, SYN_REPORT, 0);
+    writer.sync();
+}
+
+/**
+ * @brief 生成单个按键的按下或释放事件帧（附带 SYN_REPORT）
+ * @param writer 批量写入器
+ * @param keyCode 键码
+ * @param value 1 表示按下，0 表示释放
+ */
+void generateKeyEvent(UinputWriter& writer, int keyCode, int value) {
+    writer.append(EV_KEY, static_cast<uint16_t>(keyCode), value);
+    writer.sync();
 }
 
 /**
@@ -71,20 +63,19 @@ void generateKeyPressEvent(int fileDescriptor, int keyCode) {
 void registerKeyboardEvents(int fileDescriptor, const std::vector<int>& keyCodes) {
     // 启用 EV_KEY 事件类型
     if (ioctl(fileDescriptor, UI_SET_EVBIT, EV_KEY) < 0) {
-        std::cerr << "启用 EV_KEY 事件类型失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 EV_KEY 事件类型失败: %s", strerror(errno));
     }
 
     // 注册所有键码
     for (int keyCode : keyCodes) {
-        // 跳过特殊的鼠标移动映射
-        if (keyCode == REL_X_POS || keyCode == REL_X_NEG || 
-            keyCode == REL_Y_POS || keyCode == REL_Y_NEG) {
+        // 跳过特殊的鼠标移动和宏映射
+        if (isRelativeMapping(keyCode) || keyCode == MACRO_ACTION) {
             continue;
         }
 
         // 注册键码
         if (ioctl(fileDescriptor, UI_SET_KEYBIT, keyCode) < 0) {
-            std::cerr << "注册键码 " << keyCode << " 失败: " << strerror(errno) << std::endl;
+            LOG_ERROR("注册键码 %d 失败: %s", keyCode, strerror(errno));
         }
     }
 }
@@ -96,31 +87,31 @@ void registerKeyboardEvents(int fileDescriptor, const std::vector<int>& keyCodes
 void registerMouseEvents(int fileDescriptor) {
     // 启用 EV_REL 事件类型（相对坐标）
     if (ioctl(fileDescriptor, UI_SET_EVBIT, EV_REL) < 0) {
-        std::cerr << "启用 EV_REL 事件类型失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 EV_REL 事件类型失败: %s", strerror(errno));
     }
 
     // 启用 X 和 Y 轴移动
     if (ioctl(fileDescriptor, UI_SET_RELBIT, REL_X) < 0) {
-        std::cerr << "启用 REL_X 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 REL_X 失败: %s", strerror(errno));
     }
     if (ioctl(fileDescriptor, UI_SET_RELBIT, REL_Y) < 0) {
-        std::cerr << "启用 REL_Y 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 REL_Y 失败: %s", strerror(errno));
     }
 
     // 启用鼠标滚轮
     if (ioctl(fileDescriptor, UI_SET_RELBIT, REL_WHEEL) < 0) {
-        std::cerr << "启用 REL_WHEEL 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 REL_WHEEL 失败: %s", strerror(errno));
     }
 
     // 启用鼠标按钮
     if (ioctl(fileDescriptor, UI_SET_KEYBIT, BTN_LEFT) < 0) {
-        std::cerr << "启用 BTN_LEFT 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 BTN_LEFT 失败: %s", strerror(errno));
     }
     if (ioctl(fileDescriptor, UI_SET_KEYBIT, BTN_RIGHT) < 0) {
-        std::cerr << "启用 BTN_RIGHT 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 BTN_RIGHT 失败: %s", strerror(errno));
     }
     if (ioctl(fileDescriptor, UI_SET_KEYBIT, BTN_MIDDLE) < 0) {
-        std::cerr << "启用 BTN_MIDDLE 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 BTN_MIDDLE 失败: %s", strerror(errno));
     }
 }
 
@@ -133,13 +124,13 @@ int setupUinput(const std::vector<int>& keyCodes) {
     // 打开 uinput 设备
     int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
     if (fd < 0) {
-        std::cerr << "打开 /dev/uinput 失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("打开 /dev/uinput 失败: %s", strerror(errno));
         return -1;
     }
 
     // 启用同步事件
     if (ioctl(fd, UI_SET_EVBIT, EV_SYN) < 0) {
-        std::cerr << "启用 EV_SYN 事件类型失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("启用 EV_SYN 事件类型失败: %s", strerror(errno));
         close(fd);
         return -1;
     }
@@ -160,23 +151,56 @@ int setupUinput(const std::vector<int>& keyCodes) {
 
     // 创建设备
     if (ioctl(fd, UI_DEV_SETUP, &usetup) < 0) {
-        std::cerr << "设置设备信息失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("设置设备信息失败: %s", strerror(errno));
         close(fd);
         return -1;
     }
 
     if (ioctl(fd, UI_DEV_CREATE) < 0) {
-        std::cerr << "创建设备失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("创建设备失败: %s", strerror(errno));
         close(fd);
         return -1;
     }
 
-    // 等待设备初始化
-    sleep(1);
+    // 等待内核为设备生成 event 节点，而不是固定等待 1 秒
+    waitForUinputReady(fd, kUinputReadyTimeout);
 
     return fd;
 }
 
+/**
+ * @brief 等待虚拟输入设备在 sysfs 中出现并生成 event 节点
+ * @param fileDescriptor 文件描述符
+ * @param timeout 最长等待时间
+ * @return 设备是否就绪，超时或内核不支持查询时返回 false（设备仍然可以使用）
+ */
+bool waitForUinputReady(int fileDescriptor, std::chrono::milliseconds timeout) {
+    char sysname[64] = {};
+    if (ioctl(fileDescriptor, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0) {
+        LOG_DEBUG("无法查询虚拟输入设备名称，跳过就绪检测: %s", strerror(errno));
+        return false;
+    }
+
+    const std::filesystem::path devicePath = std::filesystem::path("/sys/devices/virtual/input") / sysname;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(devicePath, error)) {
+            if (entry.path().filename().string().rfind("event", 0) == 0) {
+                LOG_DEBUG("虚拟输入设备已就绪: %s/%s", sysname, entry.path().filename().c_str());
+                return true;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LOG_WARN("等待虚拟输入设备 %s 就绪超时", sysname);
+            return false;
+        }
+        usleep(1000);
+    }
+}
+
 /**
  * @brief 销毁虚拟输入设备
  * @param fileDescriptor 文件描述符
@@ -188,7 +212,7 @@ void destroyUinput(int fileDescriptor) {
 
     // 销毁设备
     if (ioctl(fileDescriptor, UI_DEV_DESTROY) < 0) {
-        std::cerr << "销毁设备失败: " << strerror(errno) << std::endl;
+        LOG_ERROR("销毁设备失败: %s", strerror(errno));
     }
 
     // 关闭文件描述符
@@ -13,30 +13,134 @@
 #ifndef UINPUT_HELPER_HPP
 #define UINPUT_HELPER_HPP
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <vector>
 #include <linux/uinput.h>
+#include "output_sink.hpp"
 
 // 定义特殊映射常量 (用负值表示特殊操作，避免与标准键码冲突)
 #define REL_X_POS (-1)  // 特殊值，表示鼠标右移
 #define REL_X_NEG (-2)  // 特殊值，表示鼠标左移
 #define REL_Y_POS (-3)  // 特殊值，表示鼠标下移
 #define REL_Y_NEG (-4)  // 特殊值，表示鼠标上移
+#define MACRO_ACTION (-5)  // 特殊值，表示按钮映射到宏（见 ButtonAction::macroId）
 
 /**
- * @brief 发送输入事件
- * @param fileDescriptor 文件描述符
- * @param type 事件类型
- * @param code 事件代码
- * @param val 事件值
+ * @brief 批量写入虚拟输入设备
+ *
+ * 事件先追加到可复用的缓冲区中，flush() 时一次交给输出目标（虚拟输入设备时为一次 write）。
+ * 一次串口读取解码出的所有动作（包括各自的 SYN_REPORT）会一起写出。
+ * 内核会为 uinput 事件重新打时间戳，因此这里不再调用 gettimeofday。
  */
-void emit(int fileDescriptor, int type, int code, int val);
+class UinputWriter {
+public:
+    static constexpr size_t kCapacity = 256;
+
+    /**
+     * @param sink 输出目标
+     */
+    explicit UinputWriter(OutputSink sink);
+
+    /**
+     * @brief 追加一个事件，缓冲区满时自动提交
+     * @param type 事件类型
+     * @param code 事件代码
+     * @param value 事件值
+     */
+    void append(uint16_t type, uint16_t code, int32_t value) {
+        if (m_count == kCapacity) {
+            flush();
+        }
+        struct input_event& event = m_buffer[m_count++];
+        event.type = type;
+        event.code = code;
+        event.value = value;
+    }
+
+    /**
+     * @brief 追加预先生成的事件帧（宏），缓冲区满时自动提交
+     * @param events 事件序列，应以 SYN_REPORT 结尾
+     */
+    void appendEvents(std::span<const struct input_event> events) {
+        while (!events.empty()) {
+            if (m_count == kCapacity) {
+                flush();
+            }
+            const size_t count = std::min(events.size(), kCapacity - m_count);
+            std::copy_n(events.begin(), count, m_buffer.begin() + m_count);
+            m_count += count;
+            events = events.subspan(count);
+        }
+    }
+
+    /**
+     * @brief 追加 SYN_REPORT，结束当前帧
+     */
+    void sync() { append(EV_SYN, SYN_REPORT, 0); }
+
+    /**
+     * @brief 把缓冲区中的所有事件一次交给输出目标
+     */
+    void flush();
+
+    /**
+     * @brief 缓冲区中尚未提交的事件数
+     */
+    size_t pending() const { return m_count; }
+
+    OutputSink& sink() { return m_sink; }
+    const OutputSink& sink() const { return m_sink; }
+
+    /**
+     * @brief 提交缓冲区后改为写入新的输出目标（重建虚拟输入设备时使用），旧目标由调用者关闭
+     * @param sink 新的输出目标
+     */
+    void setSink(OutputSink sink) {
+        flush();
+        m_sink = std::move(sink);
+    }
+
+    const UinputWriteStats& stats() const { return m_stats; }
+
+private:
+    OutputSink m_sink;
+    std::array<struct input_event, kCapacity> m_buffer{};
+    size_t m_count = 0;
+    UinputWriteStats m_stats;
+};
 
 /**
- * @brief 根据键码生成按键事件
- * @param fileDescriptor 文件描述符
+ * @brief 判断键码是否为特殊的鼠标移动映射
  * @param keyCode 键码
+ * @return 是否为 REL_X_POS/REL_X_NEG/REL_Y_POS/REL_Y_NEG
  */
-void generateKeyPressEvent(int fileDescriptor, int keyCode);
+inline bool isRelativeMapping(int keyCode) {
+    return keyCode == REL_X_POS || keyCode == REL_X_NEG || keyCode == REL_Y_POS || keyCode == REL_Y_NEG;
+}
+
+// 特殊映射每次移动的距离
+constexpr int kRelativeStep = 10;
+
+/**
+ * @brief 生成鼠标移动事件帧（附带 SYN_REPORT）
+ * @param writer 批量写入器
+ * @param keyCode 特殊映射键码 (REL_X_POS 等)
+ * @param distance 移动距离（正数，方向由键码决定）
+ */
+void generateRelativeEvent(UinputWriter& writer, int keyCode, int distance = kRelativeStep);
+
+/**
+ * @brief 生成单个按键的按下或释放事件帧（附带 SYN_REPORT）
+ * @param writer 批量写入器
+ * @param keyCode 键码
+ * @param value 1 表示按下，0 表示释放
+ */
+void generateKeyEvent(UinputWriter& writer, int keyCode, int value);
 
 /**
  * @brief 注册键盘事件
@@ -58,6 +162,17 @@ void registerMouseEvents(int fileDescriptor);
  */
 int setupUinput(const std::vector<int>& keyCodes);
 
+// 等待虚拟输入设备就绪的最长时间
+constexpr std::chrono::milliseconds kUinputReadyTimeout{200};
+
+/**
+ * @brief 等待虚拟输入设备在 sysfs 中出现并生成 event 节点
+ * @param fileDescriptor 文件描述符
+ * @param timeout 最长等待时间
+ * @return 设备是否就绪，超时或内核不支持查询时返回 false（设备仍然可以使用）
+ */
+bool waitForUinputReady(int fileDescriptor, std::chrono::milliseconds timeout);
+
 /**
  * @brief 销毁虚拟输入设备
  * @param fileDescriptor 文件描述符
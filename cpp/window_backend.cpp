@@ -0,0 +1,549 @@
+#include "window_backend.hpp"
+#include "logger.hpp"
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef TOURBOX_HAVE_XCB
+#include "x11_window_backend.hpp"
+#endif
+#ifdef TOURBOX_HAVE_SDBUS
+#include "kde_window_backend.hpp"
+#endif
+
+namespace {
+
+// 重连间隔上限
+constexpr std::chrono::milliseconds kMaxReconnectDelay(30000);
+
+// 读取非空的环境变量，不存在时返回空字符串
+std::string environment(const char* name) {
+    const char* value = getenv(name);
+    return value ? value : "";
+}
+
+// 根据环境变量推导 Hyprland 套接字目录
+std::string findHyprlandSocketDirectory() {
+    const std::string signature = environment("HYPRLAND_INSTANCE_SIGNATURE");
+    if (signature.empty()) {
+        return "";
+    }
+
+    const std::string runtimeDir = environment("XDG_RUNTIME_DIR");
+    if (!runtimeDir.empty()) {
+        std::string directory = runtimeDir + "/hypr/" + signature;
+        if (std::filesystem::exists(directory + "/.socket2.sock")) {
+            return directory;
+        }
+    }
+
+    // 旧版本 Hyprland 把套接字放在 /tmp 下
+    return "/tmp/hypr/" + signature;
+}
+
+// Sway 的 IPC 套接字，i3 使用相同的协议
+std::string findSwaySocket() {
+    std::string path = environment("SWAYSOCK");
+    return path.empty() ? environment("I3SOCK") : path;
+}
+
+// 读取字符串字段，不存在或为 null 时返回空字符串
+std::string stringField(const nlohmann::json& object, const char* key) {
+    auto it = object.find(key);
+    return it != object.end() && it->is_string() ? it->get<std::string>() : "";
+}
+
+// Sway 容器的类名：Wayland 窗口为 app_id，XWayland 窗口为 window_properties.class
+std::string swayWindowClass(const nlohmann::json& container) {
+    std::string windowClass = stringField(container, "app_id");
+    auto properties = container.find("window_properties");
+    if (windowClass.empty() && properties != container.end() && properties->is_object()) {
+        windowClass = stringField(*properties, "class");
+    }
+    return windowClass;
+}
+
+// 在布局树中查找获得焦点的节点
+const nlohmann::json* findFocusedNode(const nlohmann::json& node) {
+    if (node.value("focused", false)) {
+        return &node;
+    }
+    for (const char* children : {"nodes", "floating_nodes"}) {
+        auto it = node.find(children);
+        if (it == node.end() || !it->is_array()) {
+            continue;
+        }
+        for (const nlohmann::json& child : *it) {
+            if (const nlohmann::json* focused = findFocusedNode(child)) {
+                return focused;
+            }
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// 解析窗口后端名称
+bool parseWindowBackendKind(const std::string& text, WindowBackendKind& kind) {
+    if (text == "auto") {
+        kind = WindowBackendKind::Auto;
+    } else if (text == "hyprland") {
+        kind = WindowBackendKind::Hyprland;
+    } else if (text == "sway" || text == "i3") {
+        kind = WindowBackendKind::Sway;
+    } else if (text == "x11") {
+        kind = WindowBackendKind::X11;
+    } else if (text == "kde") {
+        kind = WindowBackendKind::Kde;
+    } else if (text == "none") {
+        kind = WindowBackendKind::None;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 创建窗口后端
+std::unique_ptr<WindowBackend> createWindowBackend(WindowBackendKind kind) {
+    if (kind == WindowBackendKind::Auto) {
+        const std::string desktop = environment("XDG_CURRENT_DESKTOP");
+        if (!environment("HYPRLAND_INSTANCE_SIGNATURE").empty()) {
+            kind = WindowBackendKind::Hyprland;
+        } else if (!findSwaySocket().empty()) {
+            kind = WindowBackendKind::Sway;
+#ifdef TOURBOX_HAVE_SDBUS
+        } else if (desktop.find("KDE") != std::string::npos) {
+            kind = WindowBackendKind::Kde;
+#endif
+#ifdef TOURBOX_HAVE_XCB
+        } else if (!environment("DISPLAY").empty()) {
+            kind = WindowBackendKind::X11;
+#endif
+        } else {
+            LOG_WARN("未检测到支持的窗口环境 (Hyprland/Sway/KDE/X11)，窗口感知已禁用");
+            return nullptr;
+        }
+    }
+
+    switch (kind) {
+        case WindowBackendKind::Hyprland:
+            return std::make_unique<HyprlandBackend>();
+        case WindowBackendKind::Sway:
+            return std::make_unique<SwayBackend>();
+        case WindowBackendKind::X11:
+#ifdef TOURBOX_HAVE_XCB
+            return std::make_unique<X11Backend>();
+#else
+            LOG_WARN("编译时未找到 xcb，不支持 X11 窗口感知");
+            return nullptr;
+#endif
+        case WindowBackendKind::Kde:
+#ifdef TOURBOX_HAVE_SDBUS
+            return std::make_unique<KdeBackend>();
+#else
+            LOG_WARN("编译时未找到 libsystemd，不支持 KDE 窗口感知");
+            return nullptr;
+#endif
+        case WindowBackendKind::Auto:
+        case WindowBackendKind::None:
+            break;
+    }
+    return nullptr;
+}
+
+// 连接 Unix 域套接字
+int connectUnixSocket(const std::string& path, bool nonBlocking) {
+    struct sockaddr_un address;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+
+    int flags = SOCK_STREAM | SOCK_CLOEXEC;
+    if (nonBlocking) {
+        flags |= SOCK_NONBLOCK;
+    }
+
+    int fd = socket(AF_UNIX, flags, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+SocketWindowBackend::~SocketWindowBackend() {
+    stop();
+}
+
+// 连接并注册到事件循环
+bool SocketWindowBackend::start(EventLoop& loop, WindowCallback onWindow) {
+    if (m_loop) {
+        return true;
+    }
+
+    m_loop = &loop;
+    m_onWindow = std::move(onWindow);
+
+    if (!connect()) {
+        LOG_WARN("无法连接 %s 事件套接字: %s，稍后重试", name(), socketPath().c_str());
+        disconnect();
+    }
+    return true;
+}
+
+// 从事件循环注销并断开连接
+void SocketWindowBackend::stop() {
+    if (!m_loop) {
+        return;
+    }
+
+    if (m_socket >= 0) {
+        m_loop->removeFd(m_socket);
+        close(m_socket);
+        m_socket = -1;
+    }
+    m_loop->cancelTimer(m_reconnectTimer);
+    m_reconnectTimer = EventLoop::kInvalidTimer;
+    m_loop = nullptr;
+}
+
+// 向事件套接字写入一条请求
+bool SocketWindowBackend::send(std::string_view data) {
+    while (true) {
+        ssize_t written = write(m_socket, data.data(), data.size());
+        if (written == static_cast<ssize_t>(data.size())) {
+            return true;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        LOG_WARN("向 %s 发送请求失败: %s", name(), written < 0 ? strerror(errno) : "部分写入");
+        return false;
+    }
+}
+
+// 连接事件套接字并注册到事件循环
+bool SocketWindowBackend::connect() {
+    m_socket = connectSocket();
+    if (m_socket < 0) {
+        return false;
+    }
+
+    if (!m_loop->addFd(m_socket, EPOLLIN | EPOLLRDHUP, [this](uint32_t events) { onReadable(events); })) {
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_buffer.clear();
+    m_reconnectDelay = std::chrono::milliseconds(1000);
+    LOG_INFO("已连接 %s 事件套接字", name());
+
+    // 先订阅事件再查询初始状态，避免错过两者之间发生的焦点变化
+    return onConnected();
+}
+
+// 断开事件套接字，并安排稍后重连
+void SocketWindowBackend::disconnect() {
+    if (m_socket >= 0) {
+        m_loop->removeFd(m_socket);
+        close(m_socket);
+        m_socket = -1;
+    }
+
+    if (m_reconnectTimer != EventLoop::kInvalidTimer) {
+        return;
+    }
+
+    m_reconnectTimer = m_loop->addTimer(m_reconnectDelay, [this]() {
+        m_reconnectTimer = EventLoop::kInvalidTimer;
+        if (!connect()) {
+            m_reconnectDelay = std::min(m_reconnectDelay * 2, kMaxReconnectDelay);
+            disconnect();
+        }
+    });
+}
+
+// 处理事件套接字上的可读事件
+void SocketWindowBackend::onReadable(uint32_t events) {
+    std::array<char, 4096> buffer;
+
+    while (true) {
+        ssize_t bytesRead = read(m_socket, buffer.data(), buffer.size());
+        if (bytesRead > 0) {
+            m_buffer.append(buffer.data(), static_cast<size_t>(bytesRead));
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+
+        // 对端关闭或出错：合成器已退出或重启
+        LOG_WARN("%s 事件套接字已断开，稍后重连", name());
+        disconnect();
+        return;
+    }
+
+    if (!consume(m_buffer)) {
+        LOG_WARN("%s 事件流不符合协议，断开后重连", name());
+        disconnect();
+        return;
+    }
+
+    if (events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) {
+        LOG_WARN("%s 事件套接字已断开，稍后重连", name());
+        disconnect();
+    }
+}
+
+HyprlandBackend::HyprlandBackend(std::string socketDirectory) : m_socketDirectory(std::move(socketDirectory)) {
+    if (m_socketDirectory.empty()) {
+        m_socketDirectory = findHyprlandSocketDirectory();
+    }
+}
+
+HyprlandBackend::~HyprlandBackend() {
+    stop();
+}
+
+bool HyprlandBackend::start(EventLoop& loop, WindowCallback onWindow) {
+    if (m_socketDirectory.empty()) {
+        LOG_WARN("未检测到 Hyprland (HYPRLAND_INSTANCE_SIGNATURE 未设置)，窗口感知已禁用");
+        return false;
+    }
+    return SocketWindowBackend::start(loop, std::move(onWindow));
+}
+
+void HyprlandBackend::stop() {
+    if (loop()) {
+        cancelQuery();
+    }
+    SocketWindowBackend::stop();
+}
+
+int HyprlandBackend::connectSocket() {
+    return connectUnixSocket(socketPath(), true);
+}
+
+// socket2 只推送事件，初始窗口通过请求 socket 查询
+bool HyprlandBackend::onConnected() {
+    queryActiveWindow();
+    return true;
+}
+
+// 通过请求 socket 查询一次当前活动窗口
+// 请求套接字是非阻塞的，回复在事件循环中读取，Hyprland 无响应时也不会阻塞串口输入
+void HyprlandBackend::queryActiveWindow() {
+    cancelQuery();
+
+    m_querySocket = connectUnixSocket(m_socketDirectory + "/.socket.sock", true);
+    if (m_querySocket < 0) {
+        LOG_WARN("无法连接 Hyprland 请求套接字，等待下一次焦点事件");
+        return;
+    }
+
+    // 请求很短，刚建立的连接上一次就能写完
+    constexpr std::string_view request = "j/activewindow";
+    if (write(m_querySocket, request.data(), request.size()) != static_cast<ssize_t>(request.size())
+        || !loop()->addFd(m_querySocket, EPOLLIN | EPOLLRDHUP, [this](uint32_t events) { onQueryReadable(events); })) {
+        LOG_WARN("向 Hyprland 请求套接字发送查询失败，等待下一次焦点事件");
+        close(m_querySocket);
+        m_querySocket = -1;
+    }
+}
+
+// 读取请求 socket 上的回复，Hyprland 写完回复后关闭连接
+void HyprlandBackend::onQueryReadable(uint32_t events) {
+    std::array<char, 4096> buffer;
+
+    while (true) {
+        ssize_t bytesRead = read(m_querySocket, buffer.data(), buffer.size());
+        if (bytesRead > 0) {
+            m_queryResponse.append(buffer.data(), static_cast<size_t>(bytesRead));
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && !(events & (EPOLLHUP | EPOLLERR))) {
+            return;
+        }
+        break;
+    }
+
+    const std::string response = std::move(m_queryResponse);
+    cancelQuery();
+
+    try {
+        nlohmann::json window = nlohmann::json::parse(response);
+        if (window.is_object()) {
+            report(window.value("class", ""), window.value("title", ""));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("解析 Hyprland 活动窗口信息失败: %s", e.what());
+    }
+}
+
+// 放弃尚未完成的查询
+void HyprlandBackend::cancelQuery() {
+    if (m_querySocket >= 0) {
+        loop()->removeFd(m_querySocket);
+        close(m_querySocket);
+        m_querySocket = -1;
+    }
+    m_queryResponse.clear();
+}
+
+// 逐行处理完整的事件
+bool HyprlandBackend::consume(std::string& buffer) {
+    size_t lineStart = 0;
+    size_t lineEnd;
+    while ((lineEnd = buffer.find('\n', lineStart)) != std::string::npos) {
+        handleEventLine(std::string_view(buffer).substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+    }
+    buffer.erase(0, lineStart);
+    return buffer.size() <= kMaxLineLength;
+}
+
+// 处理一行 Hyprland 事件
+void HyprlandBackend::handleEventLine(std::string_view line) {
+    constexpr std::string_view separator = ">>";
+    size_t separatorPos = line.find(separator);
+    if (separatorPos == std::string_view::npos) {
+        return;
+    }
+
+    std::string_view eventName = line.substr(0, separatorPos);
+    std::string_view data = line.substr(separatorPos + separator.size());
+
+    if (eventName == "activewindow") {
+        // 事件比尚未返回的查询结果更新，放弃查询
+        cancelQuery();
+
+        // 格式: activewindow>>CLASS,TITLE，标题中可能包含逗号，类名中没有
+        size_t commaPos = data.find(',');
+        if (commaPos == std::string_view::npos) {
+            report(data, "");
+        } else {
+            report(data.substr(0, commaPos), data.substr(commaPos + 1));
+        }
+    } else if (eventName == "activewindowv2") {
+        // 格式: activewindowv2>>ADDRESS，地址为空表示没有获得焦点的窗口
+        // （Hyprland 在此之前已经发送了对应的 activewindow 事件）
+        if (data.empty() || data == ",") {
+            report("", "");
+        }
+    }
+}
+
+SwayBackend::SwayBackend(std::string socketPath) : m_socketPath(std::move(socketPath)) {
+    if (m_socketPath.empty()) {
+        m_socketPath = findSwaySocket();
+    }
+}
+
+bool SwayBackend::start(EventLoop& loop, WindowCallback onWindow) {
+    if (m_socketPath.empty()) {
+        LOG_WARN("未检测到 Sway (SWAYSOCK 未设置)，窗口感知已禁用");
+        return false;
+    }
+    return SocketWindowBackend::start(loop, std::move(onWindow));
+}
+
+int SwayBackend::connectSocket() {
+    return connectUnixSocket(m_socketPath, true);
+}
+
+// 编码一条 IPC 消息：魔数、负载长度和类型（本机字节序）、负载
+std::string SwayBackend::encodeMessage(uint32_t type, std::string_view payload) {
+    constexpr std::string_view magic = "i3-ipc";
+    const uint32_t length = static_cast<uint32_t>(payload.size());
+
+    std::string message(magic);
+    message.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    message.append(reinterpret_cast<const char*>(&type), sizeof(type));
+    message.append(payload);
+    return message;
+}
+
+// 订阅窗口事件，再从布局树中取得当前获得焦点的窗口；回复都在事件套接字上异步到达
+bool SwayBackend::onConnected() {
+    return send(encodeMessage(kSubscribe, R"(["window"])")) && send(encodeMessage(kGetTree, ""));
+}
+
+// 处理缓冲区中所有完整的消息
+bool SwayBackend::consume(std::string& buffer) {
+    constexpr std::string_view magic = "i3-ipc";
+    constexpr size_t kHeaderSize = magic.size() + 2 * sizeof(uint32_t);
+
+    size_t offset = 0;
+    bool valid = true;
+    while (buffer.size() - offset >= kHeaderSize) {
+        uint32_t length;
+        uint32_t type;
+        memcpy(&length, buffer.data() + offset + magic.size(), sizeof(length));
+        memcpy(&type, buffer.data() + offset + magic.size() + sizeof(length), sizeof(type));
+        // 魔数不对或长度异常时无法再找到消息边界
+        if (std::string_view(buffer).substr(offset, magic.size()) != magic || length > kMaxMessageSize) {
+            LOG_WARN("Sway 消息头无效 (长度 %u)", length);
+            valid = false;
+            break;
+        }
+        if (buffer.size() - offset - kHeaderSize < length) {
+            break;
+        }
+        handleMessage(type, std::string_view(buffer).substr(offset + kHeaderSize, length));
+        offset += kHeaderSize + length;
+    }
+    buffer.erase(0, offset);
+    return valid;
+}
+
+// 处理一条完整的消息
+void SwayBackend::handleMessage(uint32_t type, std::string_view payload) {
+    if (type != kGetTree && type != kWindowEvent) {
+        return;
+    }
+
+    try {
+        const nlohmann::json message = nlohmann::json::parse(payload);
+
+        if (type == kGetTree) {
+            const nlohmann::json* focused = findFocusedNode(message);
+            if (focused) {
+                report(swayWindowClass(*focused), stringField(*focused, "name"));
+            }
+            return;
+        }
+
+        // 窗口事件: {"change": "focus", "container": {...}}，只关心获得焦点的窗口
+        const std::string change = message.value("change", "");
+        const nlohmann::json& container = message.at("container");
+        if (change == "focus" || (change == "title" && container.value("focused", false))) {
+            report(swayWindowClass(container), stringField(container, "name"));
+        } else if (change == "close" && container.value("focused", false)) {
+            report("", "");
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN("解析 Sway 消息失败: %s", e.what());
+    }
+}
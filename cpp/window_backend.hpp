@@ -0,0 +1,171 @@
+#ifndef WINDOW_BACKEND_HPP
+#define WINDOW_BACKEND_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "event_loop.hpp"
+
+// 活动窗口来源
+// 每个后端都由合成器或 X 服务器主动推送焦点变化，在事件循环中处理，不轮询也不创建子进程
+class WindowBackend {
+public:
+    // 活动窗口变化（包括标题变化）时调用，没有获得焦点的窗口时类名和标题都为空
+    using WindowCallback = std::function<void(std::string_view windowClass, std::string_view windowTitle)>;
+
+    virtual ~WindowBackend() = default;
+
+    // 连接并注册到事件循环；连接暂时失败时后端自己安排重连，只有无法使用时返回 false
+    virtual bool start(EventLoop& loop, WindowCallback onWindow) = 0;
+
+    // 从事件循环注销并断开连接
+    virtual void stop() = 0;
+
+    // 用于日志的名称
+    virtual const char* name() const = 0;
+};
+
+// 窗口后端类型
+enum class WindowBackendKind : uint8_t {
+    Auto,      // 根据会话环境变量选择
+    Hyprland,  // HYPRLAND_INSTANCE_SIGNATURE
+    Sway,      // SWAYSOCK（i3 的 I3SOCK 使用相同的协议）
+    X11,       // DISPLAY，需要编译时找到 xcb
+    Kde,       // KWin 脚本通过 D-Bus 通知，需要编译时找到 libsystemd
+    None,      // 不跟踪窗口，始终使用 "default" 预设
+};
+
+// 解析 auto/hyprland/sway/x11/kde/none，失败返回 false
+bool parseWindowBackendKind(const std::string& text, WindowBackendKind& kind);
+
+// 创建窗口后端；Auto 按 Hyprland、Sway、KDE、X11 的顺序选择会话中可用的第一个，都不可用或为 None 时返回 nullptr
+std::unique_ptr<WindowBackend> createWindowBackend(WindowBackendKind kind);
+
+// 连接 Unix 域套接字，失败返回 -1
+int connectUnixSocket(const std::string& path, bool nonBlocking);
+
+// 基于 Unix 域套接字事件流的后端
+// 负责注册到事件循环、读取数据和断开后按指数退避重连，子类只需要连接和解析消息
+class SocketWindowBackend : public WindowBackend {
+public:
+    ~SocketWindowBackend() override;
+
+    bool start(EventLoop& loop, WindowCallback onWindow) override;
+    void stop() override;
+
+protected:
+    // 连接事件套接字，返回非阻塞的描述符，失败返回 -1
+    virtual int connectSocket() = 0;
+
+    // 连接建立后调用：订阅事件、查询当前窗口，失败返回 false（断开并稍后重连）
+    virtual bool onConnected() { return true; }
+
+    // 处理缓冲区中所有完整的消息并从缓冲区中移除，不完整的消息留到下次；
+    // 数据不符合协议时返回 false，断开后重连，避免缓冲区无限增长
+    virtual bool consume(std::string& buffer) = 0;
+
+    // 事件套接字的路径，仅用于日志
+    virtual std::string socketPath() const = 0;
+
+    // 向事件套接字写入一条请求（非阻塞，请求很短，一次写完）
+    bool send(std::string_view data);
+
+    // 报告活动窗口
+    void report(std::string_view windowClass, std::string_view windowTitle) { m_onWindow(windowClass, windowTitle); }
+
+    // 已启动时为所在的事件循环，否则为空
+    EventLoop* loop() const { return m_loop; }
+
+private:
+    // 连接事件套接字并注册到事件循环
+    bool connect();
+
+    // 断开事件套接字，并安排稍后重连
+    void disconnect();
+
+    // 处理事件套接字上的可读事件
+    void onReadable(uint32_t events);
+
+    EventLoop* m_loop = nullptr;
+    WindowCallback m_onWindow;
+    int m_socket = -1;
+    EventLoop::TimerId m_reconnectTimer = EventLoop::kInvalidTimer;
+    std::chrono::milliseconds m_reconnectDelay{1000};
+    std::string m_buffer;  // 尚未处理的不完整消息
+};
+
+// Hyprland：socket2 上的逐行事件，例如 "activewindow>>kitty,~"
+class HyprlandBackend : public SocketWindowBackend {
+public:
+    static constexpr size_t kMaxLineLength = 1 << 20;  // 超过此长度仍没有换行时认为事件流已损坏
+
+    // socketDirectory 为空时根据 XDG_RUNTIME_DIR 和 HYPRLAND_INSTANCE_SIGNATURE 推导，
+    // 也可以指向一个模拟 Hyprland 的目录（包含 .socket.sock 和 .socket2.sock）
+    explicit HyprlandBackend(std::string socketDirectory = "");
+    ~HyprlandBackend() override;
+
+    bool start(EventLoop& loop, WindowCallback onWindow) override;
+    void stop() override;
+    const char* name() const override { return "Hyprland"; }
+
+protected:
+    int connectSocket() override;
+    bool onConnected() override;
+    bool consume(std::string& buffer) override;
+    std::string socketPath() const override { return m_socketDirectory + "/.socket2.sock"; }
+
+private:
+    // 通过请求 socket 异步查询一次当前活动窗口（仅在连接建立时调用），回复在事件循环中读取
+    void queryActiveWindow();
+
+    // 读取请求 socket 上的回复，对端关闭后解析
+    void onQueryReadable(uint32_t events);
+
+    // 放弃尚未完成的查询
+    void cancelQuery();
+
+    // 处理一行 Hyprland 事件
+    void handleEventLine(std::string_view line);
+
+    std::string m_socketDirectory;
+    int m_querySocket = -1;
+    std::string m_queryResponse;
+};
+
+// Sway/i3：IPC 套接字上订阅 window 事件，消息为 "i3-ipc" + 长度 + 类型 + JSON
+class SwayBackend : public SocketWindowBackend {
+public:
+    // socketPath 为空时使用 SWAYSOCK，其次是 I3SOCK，也可以指向一个模拟的套接字
+    explicit SwayBackend(std::string socketPath = "");
+
+    bool start(EventLoop& loop, WindowCallback onWindow) override;
+    const char* name() const override { return "Sway"; }
+
+    static constexpr size_t kMaxMessageSize = 16 << 20;  // 负载长度上限，布局树很大时也远小于此值
+
+    // 消息类型
+    static constexpr uint32_t kSubscribe = 2;
+    static constexpr uint32_t kGetTree = 4;
+    static constexpr uint32_t kEventFlag = 0x80000000u;
+    static constexpr uint32_t kWindowEvent = kEventFlag | 3;
+
+    // 编码一条 IPC 消息
+    static std::string encodeMessage(uint32_t type, std::string_view payload);
+
+protected:
+    int connectSocket() override;
+    bool onConnected() override;
+    bool consume(std::string& buffer) override;
+    std::string socketPath() const override { return m_socketPath; }
+
+private:
+    // 处理一条完整的消息
+    void handleMessage(uint32_t type, std::string_view payload);
+
+    std::string m_socketPath;
+};
+
+#endif // WINDOW_BACKEND_HPP
@@ -1,116 +1,81 @@
 #include "window_monitor.hpp"
-#include <cstdio>
-#include <stdexcept>
+#include "logger.hpp"
 
-WindowMonitor::WindowMonitor() : m_running(false) {}
+WindowMonitor::WindowMonitor() : WindowMonitor(createWindowBackend(WindowBackendKind::Auto)) {}
+
+WindowMonitor::WindowMonitor(std::unique_ptr<WindowBackend> backend)
+    : m_backend(std::move(backend)), m_snapshot(std::make_unique<WindowSnapshot>()) {}
 
 WindowMonitor::~WindowMonitor() {
     stop();
 }
 
-// 启动窗口监控线程
-void WindowMonitor::start() {
-    if (m_running) {
+// 在事件循环中启动窗口监控
+void WindowMonitor::start(EventLoop& loop) {
+    if (m_running || !m_backend) {
         return;
     }
 
-    m_running = true;
-    m_thread = std::thread(&WindowMonitor::monitorThread, this);
+    m_running = m_backend->start(loop, [this](std::string_view windowClass, std::string_view windowTitle) {
+        updateCurrentWindow(windowClass, windowTitle);
+    });
+    if (m_running) {
+        LOG_DEBUG("窗口后端: %s", m_backend->name());
+    }
 }
 
-// 停止窗口监控线程
+// 停止窗口监控
 void WindowMonitor::stop() {
     if (!m_running) {
         return;
     }
-
+    m_backend->stop();
     m_running = false;
-    if (m_thread.joinable()) {
-        m_thread.join();
-    }
 }
 
-// 获取当前窗口信息
-WindowInfo WindowMonitor::getCurrentWindow() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_currentWindow;
+// 设置预设解析函数
+void WindowMonitor::setPresetResolver(PresetResolver resolver) {
+    m_presetResolver = std::move(resolver);
 }
 
-// 执行命令并获取输出
-std::string WindowMonitor::execCommand(const std::string& cmd) {
-    std::array<char, 128> buffer;
-    std::string result;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"), pclose);
+// 用当前窗口重新解析预设并发布新快照
+void WindowMonitor::refreshPreset() {
+    publishSnapshot();
+}
 
-    if (!pipe) {
-        throw std::runtime_error("popen() failed!");
+// 窗口变化时发布新的快照
+void WindowMonitor::updateCurrentWindow(std::string_view windowClass, std::string_view windowTitle) {
+    const InternedString nextClass = m_interner.intern(windowClass);
+    const InternedString nextTitle = m_interner.intern(windowTitle);
+    if (nextClass == m_windowClass && nextTitle == m_windowTitle) {
+        return;
     }
 
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
+    m_windowClass = nextClass;
+    m_windowTitle = nextTitle;
+    // 标题不断变化的窗口会让驻留表一直增长，达到上限后只保留当前窗口
+    if (m_interner.size() >= kInternerCapacity) {
+        m_interner.retainOnly({&m_windowClass, &m_windowTitle});
     }
 
-    return result;
-}
-
-// 从 Hyprland 获取活动窗口信息
-WindowInfo WindowMonitor::getHyprlandActiveWindow() {
-    WindowInfo info;
+    LOG_INFO("窗口切换: %.*s - %.*s", static_cast<int>(m_windowClass.text.size()), m_windowClass.text.data(),
+             static_cast<int>(m_windowTitle.text.size()), m_windowTitle.text.data());
 
-    try {
-        // 尝试使用 hyprctl 获取活动窗口信息
-        std::string output = execCommand("hyprctl activewindow -j");
-
-        // 简单解析 JSON 输出
-        // 注意：这是一个简化的解析，生产环境应该使用 JSON 库
-        std::string classStr = "\"class\": \"";
-        std::string titleStr = "\"title\": \"";
-
-        auto parseField = [&output](const std::string& field) -> std::string {
-            size_t pos = output.find(field);
-            if (pos != std::string::npos) {
-                pos += field.length();
-                size_t endPos = output.find("\"", pos);
-                if (endPos != std::string::npos) {
-                    return output.substr(pos, endPos - pos);
-                }
-            }
-            return "";
-        };
-
-        info.windowClass = parseField(classStr);
-        info.windowTitle = parseField(titleStr);
-    } catch (const std::exception& e) {
-        std::cerr << "获取 Hyprland 窗口信息失败: " << e.what() << std::endl;
-    }
-
-    return info;
+    publishSnapshot();
 }
 
-// 监控线程主函数
-void WindowMonitor::monitorThread() {
-    while (m_running) {
-        try {
-            // 获取当前活动窗口
-            WindowInfo newWindow = getHyprlandActiveWindow();
+// 为当前窗口解析预设并发布快照，优先复用最早退役的快照对象
+void WindowMonitor::publishSnapshot() {
+    const uint64_t version = m_snapshot.load()->version + 1;
 
-            // 如果窗口信息有变化，更新当前窗口
-            {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                if (newWindow.windowClass != m_currentWindow.windowClass || 
-                    newWindow.windowTitle != m_currentWindow.windowTitle) {
-
-                    std::cout << "窗口切换: " << newWindow.windowClass 
-                        << " - " << newWindow.windowTitle << std::endl;
-
-                    m_currentWindow = newWindow;
-                }
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "窗口监控线程异常: " << e.what() << std::endl;
-        }
-
-        // 每秒检查一次窗口变化
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    std::unique_ptr<WindowSnapshot> next = m_snapshot.recycle();
+    if (!next) {
+        next = std::make_unique<WindowSnapshot>();
     }
+    next->version = version;
+    next->windowClassId = m_windowClass.id;
+    next->windowTitleId = m_windowTitle.id;
+    next->presetId = m_presetResolver ? m_presetResolver(m_windowClass, m_windowTitle) : 0;
+
+    m_snapshot.publish(std::move(next));
 }
@@ -2,47 +2,72 @@
 #define WINDOW_MONITOR_HPP
 
 #include <string>
-#include <thread>
-#include <mutex>
-#include <atomic>
-#include <iostream>
+#include <string_view>
+#include <functional>
 #include <array>
 #include <memory>
+#include "event_loop.hpp"
+#include "atomic_snapshot.hpp"
+#include "string_interner.hpp"
+#include "window_backend.hpp"
 
-// 窗口信息结构
-struct WindowInfo {
-    std::string windowClass;
-    std::string windowTitle;
+// 活动窗口的不可变快照，每次焦点变化发布一个新版本
+struct WindowSnapshot {
+    uint64_t version = 0;        // 单调递增，读者可据此跳过未变化的情况
+    uint32_t windowClassId = 0;  // 类名和标题在窗口监控器驻留表中的 id
+    uint32_t windowTitleId = 0;
+    int presetId = 0;            // 焦点变化时已解析好的预设 id
 };
 
+// 跟踪活动窗口并发布快照
+// 焦点变化由窗口后端（Hyprland、Sway、X11 或 KDE）主动推送，不轮询，也不创建子进程。
+// 类名和标题驻留为整数 id，判断窗口是否变化只比较 id；快照对象循环使用，
+// 因此在已经见过的窗口之间切换焦点时不分配内存
 class WindowMonitor {
 public:
+    static constexpr size_t kInternerCapacity = 4096;  // 驻留的字符串达到此数量后只保留当前窗口
+
+    // 根据窗口类名和标题解析预设 id
+    using PresetResolver = std::function<int(const InternedString& windowClass, const InternedString& windowTitle)>;
+
+    // 根据会话环境自动选择窗口后端
     WindowMonitor();
+
+    // 使用指定的窗口后端，为空时不跟踪窗口，始终使用 "default" 预设
+    explicit WindowMonitor(std::unique_ptr<WindowBackend> backend);
     ~WindowMonitor();
 
-    // 启动窗口监控线程
-    void start();
+    // 在事件循环中启动窗口监控
+    void start(EventLoop& loop);
 
-    // 停止窗口监控线程
+    // 停止窗口监控
     void stop();
 
-    // 获取当前窗口信息
-    WindowInfo getCurrentWindow();
+    // 设置预设解析函数，应在 start() 之前调用
+    void setPresetResolver(PresetResolver resolver);
 
-private:
-    // 执行命令并获取输出
-    std::string execCommand(const std::string& cmd);
+    // 用当前窗口重新解析预设并发布新快照（配置重新加载后调用）
+    void refreshPreset();
+
+    // 获取当前窗口快照，无锁且不分配内存。
+    // 只能在运行事件循环的线程中调用：快照对象循环使用，退役的快照会在之后的发布中被原地改写，
+    // 其他线程持有的指针可能读到改写到一半的内容
+    const WindowSnapshot* snapshot() const { return m_snapshot.load(); }
 
-    // 从 Hyprland 获取活动窗口信息
-    WindowInfo getHyprlandActiveWindow();
+private:
+    // 窗口变化时发布新的快照
+    void updateCurrentWindow(std::string_view windowClass, std::string_view windowTitle);
 
-    // 监控线程主函数
-    void monitorThread();
+    // 为当前窗口解析预设并发布快照
+    void publishSnapshot();
 
-    std::thread m_thread;
-    std::atomic<bool> m_running;
-    std::mutex m_mutex;
-    WindowInfo m_currentWindow;
+    std::unique_ptr<WindowBackend> m_backend;
+    bool m_running = false;
+    PresetResolver m_presetResolver;
+    StringInterner m_interner;
+    InternedString m_windowClass = StringInterner::empty();
+    InternedString m_windowTitle = StringInterner::empty();
+    AtomicSnapshot<WindowSnapshot> m_snapshot;
 };
 
 #endif // WINDOW_MONITOR_HPP
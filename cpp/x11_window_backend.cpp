@@ -0,0 +1,187 @@
+#include "x11_window_backend.hpp"
+#include "logger.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+// xcb 的回复由调用者用 free 释放
+template <typename T>
+using XcbReply = std::unique_ptr<T, decltype(&free)>;
+
+template <typename T>
+XcbReply<T> makeReply(T* reply) {
+    return XcbReply<T>(reply, &free);
+}
+
+} // namespace
+
+X11Backend::X11Backend(std::string displayName) : m_displayName(std::move(displayName)) {}
+
+X11Backend::~X11Backend() {
+    stop();
+}
+
+// 连接 X 服务器并在根窗口上监听属性变化
+bool X11Backend::start(EventLoop& loop, WindowCallback onWindow) {
+    if (m_loop) {
+        return true;
+    }
+
+    m_connection = xcb_connect(m_displayName.empty() ? nullptr : m_displayName.c_str(), nullptr);
+    if (xcb_connection_has_error(m_connection)) {
+        const char* display = m_displayName.empty() ? getenv("DISPLAY") : m_displayName.c_str();
+        LOG_WARN("无法连接 X 服务器 %s，窗口感知已禁用", display ? display : "");
+        xcb_disconnect(m_connection);
+        m_connection = nullptr;
+        return false;
+    }
+
+    m_root = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->root;
+    m_netActiveWindow = internAtom("_NET_ACTIVE_WINDOW");
+    m_netWmName = internAtom("_NET_WM_NAME");
+    m_utf8String = internAtom("UTF8_STRING");
+
+    const uint32_t eventMask = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(m_connection, m_root, XCB_CW_EVENT_MASK, &eventMask);
+    xcb_flush(m_connection);
+
+    const int fd = xcb_get_file_descriptor(m_connection);
+    if (!loop.addFd(fd, EPOLLIN, [this](uint32_t events) { onReadable(events); })) {
+        xcb_disconnect(m_connection);
+        m_connection = nullptr;
+        return false;
+    }
+
+    m_loop = &loop;
+    m_onWindow = std::move(onWindow);
+    LOG_INFO("已连接 X 服务器");
+
+    // 先监听再读取初始状态，避免错过两者之间发生的焦点变化
+    updateActiveWindow();
+    return true;
+}
+
+// 从事件循环注销并断开连接
+void X11Backend::stop() {
+    if (!m_loop) {
+        return;
+    }
+
+    m_loop->removeFd(xcb_get_file_descriptor(m_connection));
+    xcb_disconnect(m_connection);
+    m_connection = nullptr;
+    m_activeWindow = XCB_WINDOW_NONE;
+    m_loop = nullptr;
+}
+
+// 处理连接上所有排队的事件
+// 读取属性时等待回复期间收到的事件只会进入 xcb 的队列，描述符不会再次可读，因此处理完后再检查一次队列
+void X11Backend::onReadable(uint32_t /*events*/) {
+    while (m_connection) {
+        bool activeChanged = false;
+        bool titleChanged = false;
+
+        while (xcb_generic_event_t* event = xcb_poll_for_event(m_connection)) {
+            if ((event->response_type & 0x7F) == XCB_PROPERTY_NOTIFY) {
+                auto* notify = reinterpret_cast<xcb_property_notify_event_t*>(event);
+                if (notify->window == m_root && notify->atom == m_netActiveWindow) {
+                    activeChanged = true;
+                } else if (notify->window == m_activeWindow
+                           && (notify->atom == m_netWmName || notify->atom == XCB_ATOM_WM_NAME)) {
+                    titleChanged = true;
+                }
+            }
+            // 其余是错误（例如之前的活动窗口已经销毁）和不关心的事件
+            free(event);
+        }
+
+        if (xcb_connection_has_error(m_connection)) {
+            LOG_WARN("X 服务器连接已断开，窗口感知已禁用");
+            stop();
+            return;
+        }
+
+        // 一轮中的多个通知只读取一次属性
+        if (activeChanged) {
+            updateActiveWindow();
+        } else if (titleChanged) {
+            reportActiveWindow();
+        } else {
+            return;
+        }
+    }
+}
+
+// 读取 _NET_ACTIVE_WINDOW 并切换监听的窗口
+void X11Backend::updateActiveWindow() {
+    xcb_window_t window = XCB_WINDOW_NONE;
+    auto reply = makeReply(xcb_get_property_reply(
+        m_connection, xcb_get_property(m_connection, 0, m_root, m_netActiveWindow, XCB_ATOM_WINDOW, 0, 1), nullptr));
+    if (reply && xcb_get_property_value_length(reply.get()) >= static_cast<int>(sizeof(xcb_window_t))) {
+        memcpy(&window, xcb_get_property_value(reply.get()), sizeof(window));
+    }
+
+    if (window != m_activeWindow) {
+        // 不再关心之前的窗口的标题
+        const uint32_t noEvents = XCB_EVENT_MASK_NO_EVENT;
+        const uint32_t propertyEvents = XCB_EVENT_MASK_PROPERTY_CHANGE;
+        if (m_activeWindow != XCB_WINDOW_NONE) {
+            xcb_change_window_attributes(m_connection, m_activeWindow, XCB_CW_EVENT_MASK, &noEvents);
+        }
+        if (window != XCB_WINDOW_NONE) {
+            xcb_change_window_attributes(m_connection, window, XCB_CW_EVENT_MASK, &propertyEvents);
+        }
+        xcb_flush(m_connection);
+        m_activeWindow = window;
+    }
+
+    reportActiveWindow();
+}
+
+// 读取活动窗口的类名和标题并报告
+void X11Backend::reportActiveWindow() {
+    if (m_activeWindow == XCB_WINDOW_NONE) {
+        m_onWindow("", "");
+        return;
+    }
+
+    // WM_CLASS 为 "实例名\0类名\0"，规则匹配使用类名
+    const std::string wmClass = readProperty(m_activeWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING);
+    const size_t separator = wmClass.find('\0');
+    std::string windowClass = separator == std::string::npos ? wmClass : wmClass.substr(separator + 1);
+    if (!windowClass.empty() && windowClass.back() == '\0') {
+        windowClass.pop_back();
+    }
+
+    // 优先使用 UTF-8 的 _NET_WM_NAME，旧程序只设置 WM_NAME
+    std::string title = readProperty(m_activeWindow, m_netWmName, m_utf8String);
+    if (title.empty()) {
+        title = readProperty(m_activeWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING);
+    }
+
+    m_onWindow(windowClass, title);
+}
+
+// 读取窗口的一个字符串属性
+std::string X11Backend::readProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type) {
+    if (property == XCB_ATOM_NONE) {
+        return "";
+    }
+    // 长度以 4 字节为单位，标题最多读取 4KB
+    auto reply = makeReply(xcb_get_property_reply(
+        m_connection, xcb_get_property(m_connection, 0, window, property, type, 0, 1024), nullptr));
+    if (!reply) {
+        return "";
+    }
+    return std::string(static_cast<const char*>(xcb_get_property_value(reply.get())),
+                       static_cast<size_t>(xcb_get_property_value_length(reply.get())));
+}
+
+// 查询原子
+xcb_atom_t X11Backend::internAtom(const char* atomName) {
+    auto reply = makeReply(xcb_intern_atom_reply(
+        m_connection, xcb_intern_atom(m_connection, 0, static_cast<uint16_t>(strlen(atomName)), atomName), nullptr));
+    return reply ? reply->atom : static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+}
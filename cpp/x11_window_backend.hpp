@@ -0,0 +1,47 @@
+#ifndef X11_WINDOW_BACKEND_HPP
+#define X11_WINDOW_BACKEND_HPP
+
+#include <string>
+#include <xcb/xcb.h>
+#include "window_backend.hpp"
+
+// X11：监听根窗口 _NET_ACTIVE_WINDOW 的 PropertyNotify，再监听活动窗口自己的 _NET_WM_NAME 以跟踪标题变化
+// xcb 连接的描述符直接注册到事件循环，不轮询
+class X11Backend : public WindowBackend {
+public:
+    // displayName 为空时使用 DISPLAY，也可以指向 Xvfb 等测试服务器
+    explicit X11Backend(std::string displayName = "");
+    ~X11Backend() override;
+
+    bool start(EventLoop& loop, WindowCallback onWindow) override;
+    void stop() override;
+    const char* name() const override { return "X11"; }
+
+private:
+    // 处理连接上所有排队的事件
+    void onReadable(uint32_t events);
+
+    // 读取 _NET_ACTIVE_WINDOW 并切换监听的窗口
+    void updateActiveWindow();
+
+    // 读取活动窗口的类名和标题并报告
+    void reportActiveWindow();
+
+    // 读取窗口的一个字符串属性
+    std::string readProperty(xcb_window_t window, xcb_atom_t property, xcb_atom_t type);
+
+    // 查询原子，失败返回 XCB_ATOM_NONE
+    xcb_atom_t internAtom(const char* atomName);
+
+    std::string m_displayName;
+    EventLoop* m_loop = nullptr;
+    WindowCallback m_onWindow;
+    xcb_connection_t* m_connection = nullptr;
+    xcb_window_t m_root = XCB_WINDOW_NONE;
+    xcb_window_t m_activeWindow = XCB_WINDOW_NONE;
+    xcb_atom_t m_netActiveWindow = XCB_ATOM_NONE;
+    xcb_atom_t m_netWmName = XCB_ATOM_NONE;
+    xcb_atom_t m_utf8String = XCB_ATOM_NONE;
+};
+
+#endif // X11_WINDOW_BACKEND_HPP